@@ -0,0 +1,83 @@
+#include "Graph.h"
+#include "Nodes.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Times EvaluationMode::Parallel against the scheduled mode on a wide fabric of SumNodes: WIDTH
+// sources feed DEPTH layers of WIDTH two-input sums, wired like a butterfly so every layer is one
+// schedule level of WIDTH nodes.
+namespace
+{
+constexpr int WIDTH = 2048;
+constexpr int DEPTH = 64;
+constexpr int NUM_WARMUP_TICKS = 5;
+constexpr int NUM_TICKS = 100;
+
+void build_fabric(Graph &graph)
+{
+    std::vector<int> layer;
+    for (int i = 0; i < WIDTH; ++i)
+    {
+        const float phase = static_cast<float>(i) / WIDTH;
+        layer.push_back(graph.createNode<TriangleSignalNode>(-1.f, 1.f, phase, 0.01f));
+    }
+
+    for (int depth = 0; depth < DEPTH; ++depth)
+    {
+        const int stride = 1 << (depth % 11);
+        std::vector<int> next;
+        for (int i = 0; i < WIDTH; ++i)
+        {
+            const int node = graph.createNode<SumNode>(2);
+            graph.connect(layer[i], 0, node, 0);
+            graph.connect(layer[i ^ stride], 0, node, 1);
+            next.push_back(node);
+        }
+        layer = std::move(next);
+    }
+}
+
+// milliseconds per tick
+double time_ticks(Graph &graph)
+{
+    using Clock = std::chrono::steady_clock;
+
+    graph.run(NUM_WARMUP_TICKS);
+    const Clock::time_point start = Clock::now();
+    graph.run(NUM_TICKS);
+    const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count() / NUM_TICKS;
+}
+} // namespace
+
+int main()
+{
+    Graph graph;
+    build_fabric(graph);
+    std::cout << WIDTH << " x " << DEPTH << " SumNodes, " << std::thread::hardware_concurrency()
+              << " hardware threads" << std::endl;
+
+    graph.setEvaluationMode(Graph::EvaluationMode::Scheduled);
+    const double scheduled_ms = time_ticks(graph);
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "scheduled   " << scheduled_ms << " ms/tick" << std::endl;
+
+    graph.setEvaluationMode(Graph::EvaluationMode::Parallel);
+    double single_thread_ms = 0.0;
+    for (const int num_threads : {1, 2, 4, 8, 16})
+    {
+        graph.setNumThreads(num_threads);
+        const double ms = time_ticks(graph);
+        if (num_threads == 1)
+        {
+            single_thread_ms = ms;
+        }
+        std::cout << "parallel " << std::setw(2) << num_threads << " " << ms << " ms/tick, speedup "
+                  << single_thread_ms / ms << std::endl;
+    }
+    return 0;
+}
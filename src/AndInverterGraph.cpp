@@ -0,0 +1,50 @@
+#include "AndInverterGraph.h"
+
+#include <cassert>
+#include <utility>
+
+AndInverterGraph::Literal AndInverterGraph::addInput()
+{
+    nodes_.emplace_back();
+    ++num_inputs_;
+    return makeLiteral(nodes_.size() - 1);
+}
+
+AndInverterGraph::Literal AndInverterGraph::makeAnd(Literal a, Literal b)
+{
+    assert(getNode(a) < getNumNodes() && getNode(b) < getNumNodes());
+
+    // a & !a isn't folded to false: the simulated result depends on the validity of a
+    if (a == b)
+    {
+        return a;
+    }
+    if (a > b)
+    {
+        std::swap(a, b);
+    }
+
+    const std::uint64_t key = (std::uint64_t(a) << 32) | std::uint32_t(b);
+    const auto it = hashes_.find(key);
+    if (it != hashes_.end())
+    {
+        return makeLiteral(it->second);
+    }
+
+    AigNode node;
+    node.fanin0 = a;
+    node.fanin1 = b;
+    nodes_.push_back(node);
+    hashes_.emplace(key, nodes_.size() - 1);
+    return makeLiteral(nodes_.size() - 1);
+}
+
+AndInverterGraph::Literal AndInverterGraph::makeOr(Literal a, Literal b)
+{
+    return invert(makeAnd(invert(a), invert(b)));
+}
+
+AndInverterGraph::Literal AndInverterGraph::makeXor(Literal a, Literal b)
+{
+    return makeOr(makeAnd(a, invert(b)), makeAnd(invert(a), b));
+}
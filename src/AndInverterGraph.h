@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Boolean logic as two-input AND nodes with optionally inverted edges. A literal is
+// 2 * node + inverted. Nodes are structurally hashed: asking for an AND of the same two literals
+// twice returns the same node, so duplicated logic is merged as it is built.
+//
+// Node indices are topologically sorted, fanins always have smaller indices than their node.
+class AndInverterGraph
+{
+public:
+    using Literal = int;
+
+    static int getNode(Literal literal) { return literal >> 1; }
+    static bool isInverted(Literal literal) { return literal & 1; }
+    static Literal makeLiteral(int node, bool inverted = false) { return node * 2 + inverted; }
+    static Literal invert(Literal literal) { return literal ^ 1; }
+
+    Literal addInput();
+    Literal makeAnd(Literal a, Literal b);
+    Literal makeOr(Literal a, Literal b);
+    Literal makeXor(Literal a, Literal b);
+
+    int getNumNodes() const { return nodes_.size(); }
+    int getNumAnds() const { return nodes_.size() - num_inputs_; }
+    int getNumInputs() const { return num_inputs_; }
+
+    bool isInput(int node) const { return nodes_[node].fanin0 == -1; }
+    Literal getFanin0(int node) const { return nodes_[node].fanin0; }
+    Literal getFanin1(int node) const { return nodes_[node].fanin1; }
+
+private:
+    struct AigNode
+    {
+        Literal fanin0{-1}; // the smaller literal, -1 for inputs
+        Literal fanin1{-1};
+    };
+
+private:
+    std::vector<AigNode> nodes_;
+    int num_inputs_{0};
+    std::unordered_map<std::uint64_t, int> hashes_;
+};
@@ -0,0 +1,211 @@
+#include "BitParallelSimulator.h"
+
+#include "Nodes.h"
+
+#include <cassert>
+
+namespace
+{
+
+using Word = BitParallelSimulator::Word;
+
+template<class Combine>
+void combine_words(Word *values, Word *valid, const Word *all_values, const Word *all_valid,
+    const int *inputs, int num_inputs, int num_words, Word init, Combine combine)
+{
+    for (int w = 0; w < num_words; ++w)
+    {
+        values[w] = init;
+        valid[w] = ~Word{0};
+    }
+    for (int i = 0; i < num_inputs; ++i)
+    {
+        const Word *input_values = all_values + inputs[i] * num_words;
+        const Word *input_valid = all_valid + inputs[i] * num_words;
+        for (int w = 0; w < num_words; ++w)
+        {
+            values[w] = combine(values[w], input_values[w]);
+            valid[w] &= input_valid[w];
+        }
+    }
+    for (int w = 0; w < num_words; ++w)
+    {
+        values[w] &= valid[w];
+    }
+}
+
+} // namespace
+
+BitParallelSimulator::BitParallelSimulator(Graph &graph, int num_words)
+    : num_words_(num_words)
+{
+    assert(num_words >= 1);
+    values_.assign(num_words_, 0);
+    valid_.assign(num_words_, 0);
+
+    const auto get_op_code = [](const Node &node, OpCode &code) {
+        if (object_cast<AndNode>(&node))
+        {
+            code = OpCode::And;
+        }
+        else if (object_cast<OrNode>(&node))
+        {
+            code = OpCode::Or;
+        }
+        else if (object_cast<XorNode>(&node))
+        {
+            code = OpCode::Xor;
+        }
+        else if (object_cast<NotNode>(&node))
+        {
+            code = OpCode::Not;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    };
+
+    const std::vector<int> order = graph.getEvaluationOrder();
+    const int num_sorted = order.size() - graph.getNumNodesOnCycles();
+
+    for (int i = 0, count = order.size(); i < count; ++i)
+    {
+        const int id = order[i];
+        const Node &node = graph.getNode(id);
+
+        OpCode code;
+        if (!get_op_code(node, code))
+        {
+            continue;
+        }
+        const int output = add_slot(id);
+        if (i >= num_sorted)
+        {
+            // gates on a cycle never get valid inputs in Graph either
+            continue;
+        }
+
+        Op op;
+        op.code = code;
+        op.output = output;
+        op.first_input = op_inputs_.size();
+        op.num_inputs = node.getNumInputs();
+
+        for (int input = 0; input < op.num_inputs; ++input)
+        {
+            const int from = graph.getInputConnection(id, input).from;
+            int slot = 0;
+            if (from != -1)
+            {
+                // gates come before their consumers in the evaluation order
+                const auto it = node_slots_.find(from);
+                if (it != node_slots_.end())
+                {
+                    slot = it->second;
+                }
+                else if (const auto *constant = object_cast<ConstantNode>(&graph.getNode(from)))
+                {
+                    slot = add_slot(from);
+                    const Signal signal = constant->getOutput(0);
+                    for (int w = 0; w < num_words_; ++w)
+                    {
+                        values_[slot * num_words_ + w] = signal.notZero() ? ~Word{0} : 0;
+                        valid_[slot * num_words_ + w] = signal.isValid() ? ~Word{0} : 0;
+                    }
+                }
+                else
+                {
+                    slot = add_slot(from);
+                    input_nodes_.push_back(from);
+                }
+            }
+            op_inputs_.push_back(slot);
+        }
+
+        ops_.push_back(op);
+    }
+}
+
+void BitParallelSimulator::setInput(int node, int word, Word values, Word valid)
+{
+    assert(word >= 0 && word < num_words_);
+    const int slot = get_slot(node);
+    values_[slot * num_words_ + word] = values & valid;
+    valid_[slot * num_words_ + word] = valid;
+}
+
+void BitParallelSimulator::evaluate()
+{
+    const int num_words = num_words_;
+    const Word *all_values = values_.data();
+    const Word *all_valid = valid_.data();
+
+    for (const Op &op : ops_)
+    {
+        Word *values = &values_[op.output * num_words];
+        Word *valid = &valid_[op.output * num_words];
+        const int *inputs = &op_inputs_[op.first_input];
+
+        switch (op.code)
+        {
+        case OpCode::And:
+            combine_words(values, valid, all_values, all_valid, inputs, op.num_inputs, num_words,
+                ~Word{0}, [](Word lhs, Word rhs) { return lhs & rhs; });
+            break;
+        case OpCode::Or:
+            combine_words(values, valid, all_values, all_valid, inputs, op.num_inputs, num_words,
+                Word{0}, [](Word lhs, Word rhs) { return lhs | rhs; });
+            break;
+        case OpCode::Xor:
+            combine_words(values, valid, all_values, all_valid, inputs, op.num_inputs, num_words,
+                Word{0}, [](Word lhs, Word rhs) { return lhs ^ rhs; });
+            break;
+        case OpCode::Not:
+            combine_words(values, valid, all_values, all_valid, inputs, op.num_inputs, num_words,
+                ~Word{0}, [](Word lhs, Word rhs) { return lhs & ~rhs; });
+            break;
+        }
+    }
+}
+
+BitParallelSimulator::Word BitParallelSimulator::getValues(int node, int word) const
+{
+    assert(word >= 0 && word < num_words_);
+    return values_[get_slot(node) * num_words_ + word];
+}
+
+BitParallelSimulator::Word BitParallelSimulator::getValid(int node, int word) const
+{
+    assert(word >= 0 && word < num_words_);
+    return valid_[get_slot(node) * num_words_ + word];
+}
+
+Signal BitParallelSimulator::getSignal(int node, int pattern) const
+{
+    assert(pattern >= 0 && pattern < getNumPatterns());
+    const int word = pattern / WORD_BITS;
+    const Word bit = Word{1} << (pattern % WORD_BITS);
+    if ((getValid(node, word) & bit) == 0)
+    {
+        return Signal::INVALID();
+    }
+    return Signal{(getValues(node, word) & bit) != 0};
+}
+
+int BitParallelSimulator::get_slot(int node) const
+{
+    const auto it = node_slots_.find(node);
+    assert(it != node_slots_.end());
+    return it->second;
+}
+
+int BitParallelSimulator::add_slot(int node)
+{
+    const int slot = values_.size() / num_words_;
+    values_.resize(values_.size() + num_words_, 0);
+    valid_.resize(valid_.size() + num_words_, 0);
+    node_slots_[node] = slot;
+    return slot;
+}
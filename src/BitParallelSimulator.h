@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Evaluates the boolean part of a graph (AndNode, OrNode, XorNode, NotNode, ConstantNode) for
+// many independent stimulus patterns at once: bit i of every word belongs to pattern i, so each
+// gate is a handful of bitwise ops per word. Validity is tracked as a parallel bit plane.
+//
+// Every other node that drives a gate becomes an input whose patterns are set with setInput().
+// Constants are read once, when the simulator is constructed.
+class BitParallelSimulator
+{
+public:
+    using Word = std::uint64_t;
+    static constexpr int WORD_BITS = 64;
+
+    // num_words words per node; 4 words fill an AVX2 register when the loops get vectorized
+    explicit BitParallelSimulator(Graph &graph, int num_words = 1);
+
+    int getNumWords() const { return num_words_; }
+    int getNumPatterns() const { return num_words_ * WORD_BITS; }
+
+    const std::vector<int> &getInputNodes() const { return input_nodes_; }
+    bool hasNode(int node) const { return node_slots_.find(node) != node_slots_.end(); }
+
+    void setInput(int node, int word, Word values, Word valid = ~Word{0});
+    void evaluate();
+
+    Word getValues(int node, int word = 0) const;
+    Word getValid(int node, int word = 0) const;
+    // the result of one pattern in the form Graph::iterate() would produce it
+    Signal getSignal(int node, int pattern) const;
+
+private:
+    enum class OpCode
+    {
+        And,
+        Or,
+        Xor,
+        Not,
+    };
+
+    struct Op
+    {
+        OpCode code{OpCode::And};
+        int output{0};
+        int first_input{0};
+        int num_inputs{0};
+    };
+
+    int get_slot(int node) const;
+    int add_slot(int node);
+
+private:
+    int num_words_{1};
+
+    // slot 0 is never written: it stands for unconnected inputs and stays invalid
+    std::vector<Word> values_;
+    std::vector<Word> valid_;
+
+    std::vector<Op> ops_;
+    std::vector<int> op_inputs_; // slots
+    std::vector<int> input_nodes_;
+    std::unordered_map<int, int> node_slots_;
+};
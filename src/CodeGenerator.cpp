@@ -0,0 +1,270 @@
+#include "CodeGenerator.h"
+
+#include "Nodes.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <sstream>
+#include <unordered_set>
+
+namespace
+{
+
+std::string float_literal(float value)
+{
+    if (std::isnan(value))
+    {
+        return "std::numeric_limits<float>::quiet_NaN()";
+    }
+    if (std::isinf(value))
+    {
+        return value > 0 ? "std::numeric_limits<float>::infinity()"
+                         : "-std::numeric_limits<float>::infinity()";
+    }
+    // hex literals round-trip exactly
+    std::ostringstream os;
+    os << std::hexfloat << value << "f";
+    return os.str();
+}
+
+std::string value_name(int slot)
+{
+    return "v" + std::to_string(slot);
+}
+
+std::string valid_name(int slot)
+{
+    return "k" + std::to_string(slot);
+}
+
+} // namespace
+
+CodeGenerator::CodeGenerator(Graph &graph)
+{
+    const std::vector<int> order = graph.getEvaluationOrder();
+    const int num_sorted = order.size() - graph.getNumNodesOnCycles();
+    const std::unordered_set<int> on_cycles(order.begin() + num_sorted, order.end());
+
+    for (const int id : order)
+    {
+        const Node &node = graph.getNode(id);
+        if (node.getNumOutputs() > 0)
+        {
+            node_slots_[id] = num_slots_;
+            num_slots_ += node.getNumOutputs();
+        }
+    }
+
+    std::ostringstream setup;
+    std::ostringstream loop;
+    std::ostringstream store;
+    // registers compute all next states before any of them changes
+    std::ostringstream latch;
+    std::ostringstream commit;
+
+    int num_generators = 0;
+    for (const int id : order)
+    {
+        const Node &node = graph.getNode(id);
+        const int slot = node.getNumOutputs() > 0 ? node_slots_[id] : -1;
+
+        std::vector<std::string> values;
+        std::vector<std::string> valids;
+        for (int input = 0, count = node.getNumInputs(); input < count; ++input)
+        {
+            const Graph::Connection connection = graph.getInputConnection(id, input);
+            if (connection.from == -1 || on_cycles.count(connection.from))
+            {
+                values.push_back("0.0f");
+                valids.push_back("false");
+            }
+            else
+            {
+                const int from_slot = node_slots_[connection.from] + connection.output;
+                values.push_back(value_name(from_slot));
+                valids.push_back(valid_name(from_slot));
+            }
+        }
+
+        const auto join = [](const std::vector<std::string> &items, const std::string &first,
+                              const std::string &separator) {
+            std::string result = first;
+            for (const std::string &item : items)
+            {
+                result += separator + item;
+            }
+            return result;
+        };
+        const auto bools = [&values]() {
+            std::vector<std::string> result;
+            for (const std::string &value : values)
+            {
+                result.push_back("(" + value + " != 0.0f)");
+            }
+            return result;
+        };
+
+        std::string expression;
+        if (object_cast<AndNode>(&node))
+        {
+            expression = "(" + join(bools(), "true", " && ") + ") ? 1.0f : 0.0f";
+        }
+        else if (object_cast<OrNode>(&node))
+        {
+            expression = "(" + join(bools(), "false", " || ") + ") ? 1.0f : 0.0f";
+        }
+        else if (object_cast<XorNode>(&node))
+        {
+            expression = "(" + join(bools(), "false", " != ") + ") ? 1.0f : 0.0f";
+        }
+        else if (object_cast<NotNode>(&node))
+        {
+            expression = values[0] + " != 0.0f ? 0.0f : 1.0f";
+        }
+        else if (object_cast<NegateNode>(&node))
+        {
+            expression = "-" + values[0];
+        }
+        else if (object_cast<ReciprocalNode>(&node))
+        {
+            expression = "1.f / " + values[0];
+        }
+        else if (object_cast<SumNode>(&node))
+        {
+            expression = join(values, "0.0f", " + ");
+        }
+        else if (object_cast<MultiplicationNode>(&node))
+        {
+            expression = join(values, "1.0f", " * ");
+        }
+        else if (const auto *subtraction = object_cast<SubtractionNode>(&node))
+        {
+            expression = "0.0f";
+            for (int input = 0, count = values.size(); input < count; ++input)
+            {
+                expression += (subtraction->isSubtracted(input) ? " - " : " + ") + values[input];
+            }
+        }
+        else if (object_cast<ConstantNode>(&node))
+        {
+            const Signal signal = node.getOutput(0);
+            setup << "    " << valid_name(slot) << " = " << (signal.isValid() ? "true" : "false")
+                  << ";\n";
+            if (signal.isValid())
+            {
+                setup << "    " << value_name(slot) << " = " << float_literal(signal.getFloat())
+                      << ";\n";
+            }
+            continue;
+        }
+        else if (const auto *triangle = object_cast<TriangleSignalNode>(&node))
+        {
+            const std::string current = "c" + std::to_string(num_generators);
+            const std::string going_up = "u" + std::to_string(num_generators);
+            const int state = initial_state_.size();
+            initial_state_.push_back(triangle->getCurrent());
+            initial_state_.push_back(triangle->isGoingUp() ? 1.0f : 0.0f);
+            ++num_generators;
+
+            setup << "    float " << current << " = state[" << state << "];\n";
+            setup << "    bool " << going_up << " = state[" << state + 1 << "] != 0.0f;\n";
+            store << "    state[" << state << "] = " << current << ";\n";
+            store << "    state[" << state + 1 << "] = " << going_up << " ? 1.0f : 0.0f;\n";
+
+            loop << "        if (" << current << " < " << float_literal(triangle->getMin())
+                 << ")\n            " << going_up << " = true;\n";
+            loop << "        else if (" << current << " > " << float_literal(triangle->getMax())
+                 << ")\n            " << going_up << " = false;\n";
+            loop << "        " << current << " = " << going_up << " ? " << current << " + "
+                 << float_literal(triangle->getDelta()) << " : " << current << " - "
+                 << float_literal(triangle->getDelta()) << ";\n";
+            loop << "        " << value_name(slot) << " = " << current << ";\n";
+            loop << "        " << valid_name(slot) << " = true;\n";
+            continue;
+        }
+        else if (object_cast<DelayNode>(&node) || object_cast<DFlipFlopNode>(&node))
+        {
+            // the slot holds the latched state, saved in state between steps
+            const Signal initial = static_cast<const RegisterNode &>(node).getState();
+            const int state = initial_state_.size();
+            initial_state_.push_back(initial.isValid() ? initial.getFloat() : 0.0f);
+            initial_state_.push_back(initial.isValid() ? 1.0f : 0.0f);
+
+            setup << "    " << value_name(slot) << " = state[" << state << "];\n";
+            setup << "    " << valid_name(slot) << " = state[" << state + 1 << "] != 0.0f;\n";
+            store << "    state[" << state << "] = " << value_name(slot) << ";\n";
+            store << "    state[" << state + 1 << "] = " << valid_name(slot) << " ? 1.0f : 0.0f;\n";
+
+            const std::string next_value = "n" + std::to_string(slot);
+            const std::string next_valid = "m" + std::to_string(slot);
+            const std::string value = object_cast<DFlipFlopNode>(&node)
+                ? "(" + values[0] + " != 0.0f ? 1.0f : 0.0f)"
+                : values[0];
+            latch << "        const float " << next_value << " = " << value << ";\n";
+            latch << "        const bool " << next_valid << " = " << valids[0] << ";\n";
+            commit << "        " << value_name(slot) << " = " << next_value << ";\n";
+            commit << "        " << valid_name(slot) << " = " << next_valid << ";\n";
+            continue;
+        }
+        else if (object_cast<MemoryNode>(&node))
+        {
+            continue;
+        }
+        else
+        {
+            error_ = std::string("unsupported node type ") + node.getType();
+            return;
+        }
+
+        if (on_cycles.count(id))
+        {
+            // can never be calculated, its slot stays invalid
+            continue;
+        }
+
+        // a backslash or a line break would carry the comment over into the next statement
+        std::string name = node.getName();
+        std::replace_if(
+            name.begin(), name.end(),
+            [](char c) { return c == '\\' || !std::isprint(static_cast<unsigned char>(c)); }, ' ');
+        loop << "        // " << name << " [" << node.getType() << "]\n";
+        loop << "        " << valid_name(slot) << " = " << join(valids, "true", " && ")
+             << ";\n";
+        loop << "        if (" << valid_name(slot) << ")\n";
+        loop << "            " << value_name(slot) << " = " << expression << ";\n";
+    }
+
+    std::ostringstream source;
+    source << "// generated from a circuits graph\n";
+    source << "#include <limits>\n\n";
+    source << "extern \"C\" void " << STEP_FUNCTION_NAME
+           << "(float *values, unsigned char *valid, float *state, long long num_ticks)\n";
+    source << "{\n";
+    for (int slot = 0; slot < num_slots_; ++slot)
+    {
+        source << "    float " << value_name(slot) << " = values[" << slot << "];\n";
+        source << "    bool " << valid_name(slot) << " = valid[" << slot << "] != 0;\n";
+    }
+    source << setup.str();
+    source << "    for (long long tick = 0; tick < num_ticks; ++tick)\n";
+    source << "    {\n";
+    source << loop.str();
+    source << latch.str();
+    source << commit.str();
+    source << "    }\n";
+    for (int slot = 0; slot < num_slots_; ++slot)
+    {
+        source << "    values[" << slot << "] = " << value_name(slot) << ";\n";
+        source << "    valid[" << slot << "] = " << valid_name(slot) << ";\n";
+    }
+    source << store.str();
+    source << "}\n";
+    source_ = source.str();
+}
+
+int CodeGenerator::getSlot(int node, int output) const
+{
+    const auto it = node_slots_.find(node);
+    return it == node_slots_.end() ? -1 : it->second + output;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Exports a graph as a standalone C++ translation unit. Every node becomes straight-line code over
+// local variables inside the tick loop of
+//
+//     extern "C" void circuit_step(float *values, unsigned char *valid, float *state,
+//         long long num_ticks);
+//
+// values/valid hold one slot per node output (see getSlot()) and are only read on entry and
+// written back on exit. state holds the TriangleSignalNode generators and the registers,
+// initialized from getInitialState(). Supports the built-in nodes; MemoryNode is skipped since
+// there is nothing to record into, read the slot of its driver instead.
+class CodeGenerator
+{
+public:
+    static constexpr const char *STEP_FUNCTION_NAME = "circuit_step";
+
+    explicit CodeGenerator(Graph &graph);
+
+    bool isSupported() const { return error_.empty(); }
+    const std::string &getError() const { return error_; }
+
+    const std::string &getSource() const { return source_; }
+
+    int getNumSlots() const { return num_slots_; }
+    // -1 if the node has no output slot
+    int getSlot(int node, int output = 0) const;
+    const std::unordered_map<int, int> &getSlots() const { return node_slots_; }
+
+    const std::vector<float> &getInitialState() const { return initial_state_; }
+
+private:
+    std::string error_;
+    std::string source_;
+
+    int num_slots_{0};
+    // first output slot of every node with code
+    std::unordered_map<int, int> node_slots_;
+    std::vector<float> initial_state_;
+};
@@ -0,0 +1,282 @@
+#include "EventSimulator.h"
+
+#include <cassert>
+
+EventSimulator::EventSimulator(Graph &graph, int tick_length)
+    : tick_length_(tick_length)
+{
+    assert(tick_length >= 1);
+
+    values_.resize(1);
+    slot_nodes_.push_back(-1);
+    for (const int id : graph.getEvaluationOrder())
+    {
+        Node &node = graph.getNode(id);
+        const int index = nodes_.size();
+        node_indices_[id] = index;
+
+        SimNode sim_node;
+        sim_node.id = id;
+        sim_node.node = &node;
+        sim_node.first_output = values_.size();
+        nodes_.push_back(sim_node);
+
+        for (int output = 0, count = node.getNumOutputs(); output < count; ++output)
+        {
+            // registers start with their initial state, everything else is calculated first
+            values_.push_back(node.isRegister() ? node.getOutput(output) : Signal{});
+            slot_nodes_.push_back(index);
+        }
+
+        if (node.isRegister())
+        {
+            registers_.push_back(index);
+        }
+        else if (node.getNumInputs() == 0)
+        {
+            sources_.push_back(index);
+        }
+    }
+    scheduled_values_ = values_;
+
+    std::vector<int> num_fanouts(values_.size(), 0);
+    for (SimNode &sim_node : nodes_)
+    {
+        sim_node.first_input = input_slots_.size();
+        for (int input = 0, count = sim_node.node->getNumInputs(); input < count; ++input)
+        {
+            const Graph::Connection connection = graph.getInputConnection(sim_node.id, input);
+            int slot = 0;
+            if (connection.from != -1)
+            {
+                slot = nodes_[node_indices_[connection.from]].first_output + connection.output;
+                // registers ignore their inputs until they latch
+                if (!sim_node.node->isRegister())
+                {
+                    ++num_fanouts[slot];
+                }
+            }
+            input_slots_.push_back(slot);
+        }
+    }
+
+    first_fanouts_.assign(values_.size() + 1, 0);
+    for (int slot = 0, count = values_.size(); slot < count; ++slot)
+    {
+        first_fanouts_[slot + 1] = first_fanouts_[slot] + num_fanouts[slot];
+    }
+    fanouts_.resize(first_fanouts_.back());
+    std::vector<int> next_fanouts(first_fanouts_.begin(), first_fanouts_.end() - 1);
+    for (int index = 0, count = nodes_.size(); index < count; ++index)
+    {
+        const SimNode &sim_node = nodes_[index];
+        if (sim_node.node->isRegister())
+        {
+            continue;
+        }
+        for (int input = 0, num_inputs = sim_node.node->getNumInputs(); input < num_inputs; ++input)
+        {
+            const int slot = input_slots_[sim_node.first_input + input];
+            if (slot != 0)
+            {
+                fanouts_[next_fanouts[slot]++] = index;
+            }
+        }
+    }
+
+    // the first tick calculates everything once
+    pending_.assign(nodes_.size(), false);
+    for (int index = 0, count = nodes_.size(); index < count; ++index)
+    {
+        if (!nodes_[index].node->isRegister())
+        {
+            pending_[index] = true;
+            pending_nodes_.push_back(index);
+        }
+    }
+}
+
+void EventSimulator::setDelay(int node, int delay)
+{
+    assert(delay >= 1);
+    nodes_[get_index(node)].delay = delay;
+}
+
+int EventSimulator::getDelay(int node) const
+{
+    return nodes_[get_index(node)].delay;
+}
+
+void EventSimulator::iterate()
+{
+    const long long last_time = wheel_.getTime() + tick_length_ - 1;
+
+    for (const int index : sources_)
+    {
+        if (!pending_[index])
+        {
+            pending_[index] = true;
+            pending_nodes_.push_back(index);
+        }
+    }
+
+    while (true)
+    {
+        process_current_time();
+        if (wheel_.getTime() == last_time)
+        {
+            break;
+        }
+        if (wheel_.empty())
+        {
+            wheel_.skipTo(last_time);
+        }
+        else
+        {
+            wheel_.advance();
+        }
+    }
+
+    latch_registers();
+    wheel_.advance();
+}
+
+void EventSimulator::run(long long num_ticks)
+{
+    for (long long tick = 0; tick < num_ticks; ++tick)
+    {
+        iterate();
+    }
+}
+
+Signal EventSimulator::getOutput(int node, int output) const
+{
+    const SimNode &sim_node = nodes_[get_index(node)];
+    assert(output >= 0 && output < sim_node.node->getNumOutputs());
+    return values_[sim_node.first_output + output];
+}
+
+int EventSimulator::get_index(int node) const
+{
+    const auto it = node_indices_.find(node);
+    assert(it != node_indices_.end());
+    return it->second;
+}
+
+void EventSimulator::process_current_time()
+{
+    events_.clear();
+    wheel_.takeCurrent(events_);
+    for (const Event &event : events_)
+    {
+        apply(event);
+    }
+
+    // every change lands at least one time unit later, so calculating can't add pending nodes
+    for (const int index : pending_nodes_)
+    {
+        calculate(index);
+        pending_[index] = false;
+    }
+    pending_nodes_.clear();
+}
+
+void EventSimulator::calculate(int index)
+{
+    const SimNode &sim_node = nodes_[index];
+    Node &node = *sim_node.node;
+
+    node.beforeCalculate();
+    for (int input = 0, count = node.getNumInputs(); input < count; ++input)
+    {
+        const Signal value = values_[input_slots_[sim_node.first_input + input]];
+        if (value.isValid())
+        {
+            node.setInput(input, value);
+        }
+    }
+
+    ++num_calculations_;
+    const bool calculated = node.canBeCalculated();
+    if (calculated)
+    {
+        node.calculate();
+    }
+    for (int output = 0, count = node.getNumOutputs(); output < count; ++output)
+    {
+        schedule(sim_node, output, calculated ? node.getOutput(output) : Signal::INVALID());
+    }
+}
+
+void EventSimulator::latch_registers()
+{
+    for (const int index : registers_)
+    {
+        const SimNode &sim_node = nodes_[index];
+        Node &node = *sim_node.node;
+
+        node.beforeCalculate();
+        for (int input = 0, count = node.getNumInputs(); input < count; ++input)
+        {
+            const Signal value = values_[input_slots_[sim_node.first_input + input]];
+            if (value.isValid())
+            {
+                node.setInput(input, value);
+            }
+        }
+        node.latch();
+    }
+
+    // committed at the tick boundary once all registers latched, so a register feeding another
+    // one isn't seen by it before the next tick
+    for (const int index : registers_)
+    {
+        const SimNode &sim_node = nodes_[index];
+        for (int output = 0, count = sim_node.node->getNumOutputs(); output < count; ++output)
+        {
+            const int slot = sim_node.first_output + output;
+            const Signal value = sim_node.node->getOutput(output);
+            scheduled_values_[slot] = value;
+            apply({slot, value});
+        }
+    }
+}
+
+void EventSimulator::apply(const Event &event)
+{
+    Signal &value = values_[event.slot];
+    if (value.isIdentical(event.value))
+    {
+        return;
+    }
+    value = event.value;
+    ++num_events_;
+
+    if (change_callback_)
+    {
+        const SimNode &sim_node = nodes_[slot_nodes_[event.slot]];
+        change_callback_(
+            wheel_.getTime(), sim_node.id, event.slot - sim_node.first_output, event.value);
+    }
+
+    for (int i = first_fanouts_[event.slot]; i < first_fanouts_[event.slot + 1]; ++i)
+    {
+        const int index = fanouts_[i];
+        if (!pending_[index])
+        {
+            pending_[index] = true;
+            pending_nodes_.push_back(index);
+        }
+    }
+}
+
+void EventSimulator::schedule(const SimNode &sim_node, int output, Signal value)
+{
+    const int slot = sim_node.first_output + output;
+    if (scheduled_values_[slot].isIdentical(value))
+    {
+        return;
+    }
+    scheduled_values_[slot] = value;
+    wheel_.schedule(wheel_.getTime() + sim_node.delay, {slot, value});
+}
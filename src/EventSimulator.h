@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Graph.h"
+#include "TimingWheel.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Discrete-event simulation of a graph where every node has an integer propagation delay. A node
+// is only calculated at the time one of its inputs changes; when that changes an output, the new
+// value is scheduled delay time units later on a TimingWheel. Delays are transport delays: every
+// change arrives, also pulses shorter than the delay, so glitches and hazards are visible through
+// the change callback.
+//
+// One tick of the graph spans getTickLength() time units. Sources (nodes without inputs) are
+// calculated at the start of every tick. Registers latch at its last time unit and their new
+// state is visible right away, like after Graph::iterate(); the nodes they feed see it at the
+// start of the next tick, so the delay of a register isn't used. With all delays along a path
+// shorter than a tick, the outputs, register outputs included, match Graph::iterate() at the end
+// of each tick.
+// Stateful nodes with inputs, like MemoryNode, only see the changes of their inputs.
+//
+// Calculates the nodes of the graph itself, whose structure must not change meanwhile.
+class EventSimulator
+{
+public:
+    using ChangeCallback = std::function<void(long long time, int node, int output, Signal value)>;
+
+    explicit EventSimulator(Graph &graph, int tick_length = 16);
+
+    int getTickLength() const { return tick_length_; }
+
+    // delay >= 1, 1 by default; affects the changes scheduled afterwards, not used for registers
+    void setDelay(int node, int delay);
+    int getDelay(int node) const;
+
+    // called for every output change, in time order
+    void setChangeCallback(ChangeCallback callback) { change_callback_ = std::move(callback); }
+
+    // simulates one tick
+    void iterate();
+    void run(long long num_ticks);
+
+    long long getTime() const { return wheel_.getTime(); }
+    Signal getOutput(int node, int output = 0) const;
+
+    // output changes applied and nodes calculated so far
+    long long getNumEvents() const { return num_events_; }
+    long long getNumCalculations() const { return num_calculations_; }
+
+private:
+    struct Event
+    {
+        int slot{0};
+        Signal value;
+    };
+
+    struct SimNode
+    {
+        int id{-1};
+        Node *node{nullptr};
+        int delay{1};
+        int first_output{0}; // slot
+        int first_input{0};  // index into input_slots_
+    };
+
+    int get_index(int node) const;
+    void process_current_time();
+    void calculate(int index);
+    void latch_registers();
+    // sets a slot and marks the nodes it feeds for calculation
+    void apply(const Event &event);
+    void schedule(const SimNode &sim_node, int output, Signal value);
+
+private:
+    int tick_length_{0};
+    TimingWheel<Event> wheel_;
+
+    std::vector<SimNode> nodes_;
+    std::unordered_map<int, int> node_indices_;
+    std::vector<int> sources_;   // indices into nodes_
+    std::vector<int> registers_; // indices into nodes_
+
+    // slot 0 stands for unconnected inputs and stays invalid
+    std::vector<Signal> values_;
+    std::vector<Signal> scheduled_values_; // the last value scheduled for each slot
+    std::vector<int> slot_nodes_;          // indices into nodes_
+    std::vector<int> first_fanouts_;       // indices into fanouts_, one more than slots
+    std::vector<int> fanouts_;             // indices into nodes_
+    std::vector<int> input_slots_;
+
+    std::vector<char> pending_; // indexed like nodes_
+    std::vector<int> pending_nodes_;
+    std::vector<Event> events_;
+
+    ChangeCallback change_callback_;
+    long long num_events_{0};
+    long long num_calculations_{0};
+};
@@ -0,0 +1,353 @@
+#include "FixedPointSimulator.h"
+
+#include "Nodes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#ifdef __AVX2__
+    #include <immintrin.h>
+#endif
+
+namespace
+{
+// bytes of the widest SIMD register
+constexpr int LANE_ALIGNMENT_BYTES = 64;
+
+// wide enough for the sum or the product of two values
+template<class T>
+using Wide = std::conditional_t<sizeof(T) == 2, std::int32_t, std::int64_t>;
+
+template<class T>
+T saturate(Wide<T> value)
+{
+    constexpr Wide<T> min = std::numeric_limits<T>::min();
+    constexpr Wide<T> max = std::numeric_limits<T>::max();
+    return static_cast<T>(value < min ? min : (value > max ? max : value));
+}
+
+template<class T>
+void add_lanes(T *out, const T *in, int count)
+{
+    for (int lane = 0; lane < count; ++lane)
+    {
+        out[lane] = saturate<T>(Wide<T>(out[lane]) + Wide<T>(in[lane]));
+    }
+}
+
+// rounding is added before the fraction bits are shifted out, 0 truncates
+template<class T>
+void multiply_lanes(T *out, const T *in, int count, int fraction_bits, Wide<T> rounding)
+{
+    for (int lane = 0; lane < count; ++lane)
+    {
+        const Wide<T> product = Wide<T>(out[lane]) * Wide<T>(in[lane]);
+        out[lane] = saturate<T>((product + rounding) >> fraction_bits);
+    }
+}
+
+template<class T>
+void negate_lanes(T *out, const T *in, int count)
+{
+    for (int lane = 0; lane < count; ++lane)
+    {
+        out[lane] = saturate<T>(-Wide<T>(in[lane]));
+    }
+}
+
+#ifdef __AVX2__
+
+// Saturating int16_t kernels, 16 lanes per instruction. Strides are multiples of 32 lanes.
+
+void add_lanes(std::int16_t *out, const std::int16_t *in, int count)
+{
+    for (int lane = 0; lane < count; lane += 16)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(out + lane));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + lane));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + lane), _mm256_adds_epi16(a, b));
+    }
+}
+
+void negate_lanes(std::int16_t *out, const std::int16_t *in, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    for (int lane = 0; lane < count; lane += 16)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + lane));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + lane), _mm256_subs_epi16(zero, a));
+    }
+}
+
+// Q15 rounded to nearest is what vpmulhrsw computes, other formats take the generic loop
+void multiply_lanes(
+    std::int16_t *out, const std::int16_t *in, int count, int fraction_bits, std::int32_t rounding)
+{
+    if (fraction_bits != 15 || rounding == 0)
+    {
+        multiply_lanes<std::int16_t>(out, in, count, fraction_bits, rounding);
+        return;
+    }
+    const __m256i min = _mm256_set1_epi16(std::numeric_limits<std::int16_t>::min());
+    for (int lane = 0; lane < count; lane += 16)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(out + lane));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + lane));
+        __m256i product = _mm256_mulhrs_epi16(a, b);
+        // only -1 * -1 overflows, to -1; flip it to the largest value
+        product = _mm256_xor_si256(product, _mm256_cmpeq_epi16(product, min));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + lane), product);
+    }
+}
+
+#endif
+
+} // namespace
+
+template<class T>
+FixedPointSimulator<T>::FixedPointSimulator(
+    Graph &graph, int num_lanes, int fraction_bits, Rounding rounding)
+    : num_lanes_(num_lanes)
+    , fraction_bits_(fraction_bits)
+    , rounding_(rounding)
+{
+    assert(num_lanes >= 1);
+    assert(fraction_bits >= 0 && fraction_bits <= std::numeric_limits<T>::digits);
+
+    constexpr int lane_alignment = LANE_ALIGNMENT_BYTES / sizeof(T);
+    stride_ = (num_lanes + lane_alignment - 1) / lane_alignment * lane_alignment;
+    values_.assign(stride_, 0);
+    valid_.assign(1, false);
+
+    const auto get_op_code = [](const Node &node, OpCode &code) {
+        if (object_cast<SumNode>(&node))
+        {
+            code = OpCode::Sum;
+        }
+        else if (object_cast<MultiplicationNode>(&node))
+        {
+            code = OpCode::Multiplication;
+        }
+        else if (object_cast<NegateNode>(&node))
+        {
+            code = OpCode::Negate;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    };
+
+    const std::vector<int> order = graph.getEvaluationOrder();
+    const int num_sorted = order.size() - graph.getNumNodesOnCycles();
+
+    for (int i = 0, count = order.size(); i < count; ++i)
+    {
+        const int id = order[i];
+        const Node &node = graph.getNode(id);
+
+        OpCode code;
+        if (!get_op_code(node, code))
+        {
+            continue;
+        }
+        const int output = add_slot(id);
+        if (i >= num_sorted)
+        {
+            continue;
+        }
+
+        Op op;
+        op.code = code;
+        op.output = output;
+        op.first_input = op_inputs_.size();
+        op.num_inputs = node.getNumInputs();
+
+        for (int input = 0; input < op.num_inputs; ++input)
+        {
+            const int from = graph.getInputConnection(id, input).from;
+            int slot = 0;
+            if (from != -1)
+            {
+                const auto it = node_slots_.find(from);
+                if (it != node_slots_.end())
+                {
+                    slot = it->second;
+                }
+                else
+                {
+                    Node &from_node = graph.getNode(from);
+                    slot = add_slot(from);
+                    input_nodes_.push_back(from);
+                    if (object_cast<ConstantNode>(&from_node))
+                    {
+                        broadcast(slot, from_node.getOutput(0));
+                    }
+                    else if (from_node.getNumInputs() == 0)
+                    {
+                        sources_.push_back({&from_node, slot});
+                    }
+                }
+            }
+            op_inputs_.push_back(slot);
+        }
+
+        ops_.push_back(op);
+    }
+}
+
+template<class T>
+void FixedPointSimulator<T>::setLanes(int node, const T *values)
+{
+    const int slot = get_slot(node);
+    std::copy(values, values + num_lanes_, &values_[slot * stride_]);
+    valid_[slot] = true;
+
+    sources_.erase(std::remove_if(sources_.begin(), sources_.end(),
+                       [slot](const Source &source) { return source.slot == slot; }),
+        sources_.end());
+}
+
+template<class T>
+void FixedPointSimulator<T>::iterate()
+{
+    for (const Source &source : sources_)
+    {
+        source.node->beforeCalculate();
+        if (source.node->canBeCalculated())
+        {
+            source.node->calculate();
+        }
+        broadcast(source.slot, source.node->getOutput(0));
+    }
+
+    const int stride = stride_;
+    const int fraction_bits = fraction_bits_;
+    const Wide<T> rounding = rounding_ == Rounding::Nearest && fraction_bits > 0
+        ? Wide<T>(1) << (fraction_bits - 1)
+        : 0;
+    for (const Op &op : ops_)
+    {
+        T *out = &values_[op.output * stride];
+        const int *inputs = &op_inputs_[op.first_input];
+
+        bool valid = true;
+        for (int i = 0; i < op.num_inputs; ++i)
+        {
+            valid = valid && valid_[inputs[i]];
+        }
+        valid_[op.output] = valid;
+        if (!valid)
+        {
+            continue;
+        }
+
+        switch (op.code)
+        {
+        case OpCode::Sum:
+            if (op.num_inputs == 0)
+            {
+                std::fill(out, out + stride, T{0});
+                break;
+            }
+            // starting from the first input instead of 0 or 1 also works when 1 doesn't fit
+            std::copy(&values_[inputs[0] * stride], &values_[(inputs[0] + 1) * stride], out);
+            for (int i = 1; i < op.num_inputs; ++i)
+            {
+                add_lanes(out, &values_[inputs[i] * stride], stride);
+            }
+            break;
+        case OpCode::Multiplication:
+            if (op.num_inputs == 0)
+            {
+                std::fill(out, out + stride, toFixed(1.0f));
+                break;
+            }
+            std::copy(&values_[inputs[0] * stride], &values_[(inputs[0] + 1) * stride], out);
+            for (int i = 1; i < op.num_inputs; ++i)
+            {
+                multiply_lanes(out, &values_[inputs[i] * stride], stride, fraction_bits, rounding);
+            }
+            break;
+        case OpCode::Negate: negate_lanes(out, &values_[inputs[0] * stride], stride); break;
+        }
+    }
+}
+
+template<class T>
+bool FixedPointSimulator<T>::isValid(int node) const
+{
+    return valid_[get_slot(node)];
+}
+
+template<class T>
+const T *FixedPointSimulator<T>::getLanes(int node) const
+{
+    return &values_[get_slot(node) * stride_];
+}
+
+template<class T>
+Signal FixedPointSimulator<T>::getSignal(int node, int lane) const
+{
+    assert(lane >= 0 && lane < num_lanes_);
+    if (!isValid(node))
+    {
+        return Signal::INVALID();
+    }
+    return Signal{toFloat(getLanes(node)[lane])};
+}
+
+template<class T>
+T FixedPointSimulator<T>::toFixed(float value) const
+{
+    if (std::isnan(value))
+    {
+        return 0;
+    }
+    const double scaled = std::round(std::ldexp(static_cast<double>(value), fraction_bits_));
+    const double min = std::numeric_limits<T>::min();
+    const double max = std::numeric_limits<T>::max();
+    return static_cast<T>(std::clamp(scaled, min, max));
+}
+
+template<class T>
+float FixedPointSimulator<T>::toFloat(T value) const
+{
+    return static_cast<float>(std::ldexp(static_cast<double>(value), -fraction_bits_));
+}
+
+template<class T>
+int FixedPointSimulator<T>::get_slot(int node) const
+{
+    const auto it = node_slots_.find(node);
+    assert(it != node_slots_.end());
+    return it->second;
+}
+
+template<class T>
+int FixedPointSimulator<T>::add_slot(int node)
+{
+    const int slot = valid_.size();
+    values_.resize(values_.size() + stride_, 0);
+    valid_.push_back(false);
+    node_slots_[node] = slot;
+    return slot;
+}
+
+template<class T>
+void FixedPointSimulator<T>::broadcast(int slot, Signal signal)
+{
+    valid_[slot] = signal.isValid();
+    if (signal.isValid())
+    {
+        std::fill(&values_[slot * stride_], &values_[(slot + 1) * stride_],
+            toFixed(signal.getFloat()));
+    }
+}
+
+template class FixedPointSimulator<std::int16_t>;
+template class FixedPointSimulator<std::int32_t>;
@@ -1,32 +1,55 @@
 #include "Graph.h"
 
-#include <functional>
-#include <unordered_set>
-
 int Graph::addNode(std::unique_ptr<Node> node)
 {
-    const int id = generate_id();
-    nodes_[id] = std::move(node);
+    return add_node(NodePtr(node.release(), NodeDeleter{}));
+}
+
+int Graph::add_node(NodePtr node)
+{
+    NodeEntry entry;
+    entry.input_connections.assign(node->getNumInputs(), -1);
+    entry.is_register = node->isRegister();
+    entry.node = std::move(node);
+    const int id = nodes_.insert(std::move(entry));
+    if (get_entry(id).is_register)
+    {
+        registers_.push_back(id);
+    }
+    invalidate_schedule();
     return id;
 }
 
 Node &Graph::getNode(int node)
 {
-    const auto it = nodes_.find(node);
-    assert(it != nodes_.end());
-    return *it->second;
+    return *get_entry(node).node;
 }
 
 const Node &Graph::getNode(int node) const
 {
-    const auto it = nodes_.find(node);
-    assert(it != nodes_.end());
-    return *it->second;
+    return *get_entry(node).node;
 }
 
 void Graph::removeNode(int node)
 {
+    NodeEntry &entry = get_entry(node);
+    for (const int idx : entry.input_connections)
+    {
+        if (idx != -1)
+        {
+            remove_connection(idx);
+        }
+    }
+    while (!entry.output_connections.empty())
+    {
+        remove_connection(entry.output_connections.back());
+    }
+    if (entry.is_register)
+    {
+        registers_.erase(std::find(registers_.begin(), registers_.end(), node));
+    }
     nodes_.erase(node);
+    invalidate_schedule();
 }
 
 void Graph::connect(int from, int output, int to, int input)
@@ -41,102 +64,614 @@ void Graph::connect(int from, int output, int to, int input)
     connection.output = output;
     connection.to = to;
     connection.input = input;
+    // Any output may drive any input: a bool output is a float of 0 or 1, and a float output
+    // driving a bool input stays a float wire that the input only compares to zero. So the kind
+    // is not checked against the input, it tells engines how the wire can be stored.
+    connection.kind = getNode(from).getOutputKind(output);
+
+    int idx;
+    if (free_connections_.empty())
+    {
+        idx = connections_.size();
+        connections_.push_back(connection);
+        output_positions_.push_back(-1);
+    }
+    else
+    {
+        idx = free_connections_.back();
+        free_connections_.pop_back();
+        connections_[idx] = connection;
+    }
 
-    connections_.push_back(connection);
+    std::vector<int> &outputs = get_entry(from).output_connections;
+    output_positions_[idx] = outputs.size();
+    outputs.push_back(idx);
+    NodeEntry &to_entry = get_entry(to);
+    to_entry.input_connections[input] = idx;
+    ++to_entry.num_connected_inputs;
+    invalidate_schedule();
 }
 
 void Graph::disconnectInput(int node, int input)
 {
-    connections_.erase(std::remove_if(connections_.begin(), connections_.end(),
-                           [node, input](const Connection &connection) {
-                               return connection.to == node && connection.input == input;
-                           }),
-        connections_.end());
+    assert(input >= 0 && input < getNode(node).getNumInputs());
+
+    const int idx = get_entry(node).input_connections[input];
+    if (idx != -1)
+    {
+        remove_connection(idx);
+        invalidate_schedule();
+    }
 }
 
 void Graph::iterate()
 {
-    for (const auto &it : nodes_)
+    run_ticks(1, nullptr);
+}
+
+void Graph::run(long long num_ticks)
+{
+    run_ticks(num_ticks, nullptr);
+}
+
+long long Graph::runUntil(const StopPredicate &stop, long long max_ticks)
+{
+    return run_ticks(max_ticks, &stop);
+}
+
+void Graph::addObserver(TickObserver *observer)
+{
+    assert(std::find(observers_.begin(), observers_.end(), observer) == observers_.end());
+    observers_.push_back(observer);
+}
+
+void Graph::removeObserver(TickObserver *observer)
+{
+    observers_.erase(std::remove(observers_.begin(), observers_.end(), observer), observers_.end());
+}
+
+long long Graph::run_ticks(long long max_ticks, const StopPredicate *stop)
+{
+    // the mode is resolved once per run, not once per tick
+    switch (evaluation_mode_)
     {
-        it.second->beforeCalculate();
+    case EvaluationMode::Scheduled:
+        return run_loop(max_ticks, stop, [this]() { iterate_scheduled(); });
+    case EvaluationMode::Worklist:
+        return run_loop(max_ticks, stop, [this]() { iterate_worklist(); });
+    case EvaluationMode::Incremental:
+        return run_loop(max_ticks, stop, [this]() { iterate_incremental(); });
+    case EvaluationMode::Parallel:
+        return run_loop(max_ticks, stop, [this]() { iterate_parallel(); });
     }
+    return 0;
+}
 
-    std::unordered_set<int> calculated;
+template<class Iterate>
+long long Graph::run_loop(long long max_ticks, const StopPredicate *stop, Iterate iterate)
+{
+    const long long first_tick = tick_;
+    while (tick_ - first_tick < max_ticks)
+    {
+        iterate();
+        latch_registers();
+        for (TickObserver *observer : observers_)
+        {
+            observer->onTick(*this, tick_);
+        }
+        ++tick_;
 
-    const auto is_calculated = [&calculated](int node) {
-        return calculated.find(node) != calculated.end();
-    };
+        if (stop && (*stop)(*this))
+        {
+            break;
+        }
+    }
 
-    const auto mark_calculated = [&calculated](int node) {
-        calculated.insert(node);
-    };
+    for (TickObserver *observer : observers_)
+    {
+        observer->onRunFinished(*this, first_tick, tick_ - first_tick);
+    }
+    return tick_ - first_tick;
+}
+
+void Graph::setNumThreads(int num_threads)
+{
+    assert(num_threads >= 1);
+    if (num_threads != num_threads_)
+    {
+        num_threads_ = num_threads;
+        thread_pool_.reset();
+    }
+}
+
+void Graph::iterate_scheduled()
+{
+    if (!schedule_valid_)
+    {
+        compile_schedule();
+    }
 
-    std::function<void(int node)> calculate;
-    calculate = [this, &calculate, &is_calculated, &mark_calculated](int node_id) {
-        Node &node = getNode(node_id);
+    for (const ScheduledNode &scheduled : schedule_)
+    {
+        scheduled.node->beforeCalculate();
+    }
+
+    for (const ScheduledNode &scheduled : schedule_)
+    {
+        Node &node = *scheduled.node;
+        if (!node.canBeCalculated())
+        {
+            continue;
+        }
         node.calculate();
-        mark_calculated(node_id);
 
-        for (const int idx : get_connections_from(node_id))
+        const ScheduledConnection *connection = &schedule_connections_[scheduled.first_connection];
+        for (int i = 0; i < scheduled.num_connections; ++i, ++connection)
+        {
+            connection->to->setInput(connection->input, node.getOutput(connection->output));
+        }
+    }
+}
+
+void Graph::iterate_worklist()
+{
+    using Slots = SlotMap<NodeEntry>;
+
+    const std::vector<int> &ids = nodes_.getIds();
+    std::vector<NodeEntry> &entries = nodes_.getValues();
+
+    num_pending_inputs_.resize(nodes_.getNumSlots());
+    worklist_.clear();
+    worklist_.reserve(ids.size());
+
+    for (int i = 0, count = ids.size(); i < count; ++i)
+    {
+        entries[i].node->beforeCalculate();
+
+        // registers output what they latched last tick, so they don't wait for their inputs
+        const int num_pending = entries[i].is_register ? 0 : entries[i].num_connected_inputs;
+        num_pending_inputs_[Slots::getSlotIndex(ids[i])] = num_pending;
+        if (num_pending == 0)
+        {
+            worklist_.push_back(ids[i]);
+        }
+    }
+
+    // a node is visited once all its drivers were visited, so it sees the same inputs as in
+    // the scheduled mode; the worklist only grows, so stack use doesn't depend on graph depth
+    // worklist_ grows inside the loop, so its size is read on every step
+    for (int next = 0; next < static_cast<int>(worklist_.size()); ++next)
+    {
+        const NodeEntry &entry = get_entry(worklist_[next]);
+        Node &node = *entry.node;
+        const bool calculated = node.canBeCalculated();
+        if (calculated)
+        {
+            node.calculate();
+        }
+
+        for (const int idx : entry.output_connections)
         {
             const Connection &connection = connections_[idx];
-            const int output = connection.output;
-            const int to = connection.to;
-            const int input = connection.input;
+            const NodeEntry &to_entry = get_entry(connection.to);
+            if (calculated)
+            {
+                to_entry.node->setInput(connection.input, node.getOutput(connection.output));
+            }
+            if (!to_entry.is_register
+                && --num_pending_inputs_[Slots::getSlotIndex(connection.to)] == 0)
+            {
+                worklist_.push_back(connection.to);
+            }
+        }
+    }
 
-            Node &node_to = getNode(to);
-            node_to.setInput(input, node.getOutput(output));
+    // nodes on a cycle
+    for (int i = 0, count = ids.size(); i < count; ++i)
+    {
+        if (num_pending_inputs_[Slots::getSlotIndex(ids[i])] > 0)
+        {
+            Node &node = *entries[i].node;
+            if (node.canBeCalculated())
+            {
+                node.calculate();
+                for (const int idx : entries[i].output_connections)
+                {
+                    const Connection &connection = connections_[idx];
+                    getNode(connection.to)
+                        .setInput(connection.input, node.getOutput(connection.output));
+                }
+            }
+        }
+    }
+}
 
-            if (!is_calculated(to) && node_to.canBeCalculated())
+void Graph::iterate_incremental()
+{
+    if (!incremental_primed_)
+    {
+        iterate_scheduled();
+
+        incremental_outputs_.resize(num_scheduled_outputs_);
+        incremental_dirty_.assign(schedule_.size(), false);
+        for (const ScheduledNode &scheduled : schedule_)
+        {
+            for (int i = 0, count = scheduled.node->getNumOutputs(); i < count; ++i)
             {
-                calculate(to);
+                incremental_outputs_[scheduled.first_output + i] = scheduled.node->getOutput(i);
             }
         }
-    };
+        incremental_primed_ = true;
+        return;
+    }
+
+    // inputs are not reset: a node that isn't recalculated keeps what it got last tick
+    for (int index = 0, count = schedule_.size(); index < count; ++index)
+    {
+        const ScheduledNode &scheduled = schedule_[index];
+        if (!scheduled.evaluate_every_tick && !incremental_dirty_[index])
+        {
+            continue;
+        }
+        incremental_dirty_[index] = false;
+
+        Node &node = *scheduled.node;
+        const bool calculated = node.canBeCalculated();
+        if (calculated)
+        {
+            node.calculate();
+        }
+        else
+        {
+            // the node itself ends up like in a full tick: the output gets invalid, the inputs
+            // that arrived stay
+            const int num_inputs = node.getNumInputs();
+            incremental_inputs_.resize(num_inputs);
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                incremental_inputs_[i] = node.getInput(i);
+            }
+            node.reset();
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                node.setInput(i, incremental_inputs_[i]);
+            }
+        }
+
+        const ScheduledConnection *connection = &schedule_connections_[scheduled.first_connection];
+        for (int i = 0; i < scheduled.num_connections; ++i, ++connection)
+        {
+            const Signal output = node.getOutput(connection->output);
+            Signal &last_output = incremental_outputs_[scheduled.first_output + connection->output];
+            if (!output.isIdentical(last_output))
+            {
+                // a full tick doesn't push outputs of nodes that weren't calculated, the invalid
+                // output only reaches inputs that beforeCalculate() would have cleared
+                if (calculated || !connection->to_keeps_inputs)
+                {
+                    connection->to->setInput(connection->input, output);
+                }
+                incremental_dirty_[connection->to_index] = true;
+            }
+        }
+        for (int i = 0, num_outputs = node.getNumOutputs(); i < num_outputs; ++i)
+        {
+            incremental_outputs_[scheduled.first_output + i] = node.getOutput(i);
+        }
+    }
+}
 
-    for (const auto &it : nodes_)
+void Graph::iterate_parallel()
+{
+    if (!schedule_valid_)
     {
-        const int node_id = it.first;
-        const Node &node = *it.second;
+        compile_schedule();
+    }
+    if (!thread_pool_ && num_threads_ > 1)
+    {
+        thread_pool_ = std::make_unique<ThreadPool>(num_threads_);
+    }
+
+    parallel_calculated_.assign(schedule_.size(), false);
+
+    const auto pull_inputs = [this](const ScheduledNode &scheduled) {
+        const ScheduledInput *input = &schedule_inputs_[scheduled.first_input];
+        for (int i = 0; i < scheduled.num_inputs; ++i, ++input)
+        {
+            if (parallel_calculated_[input->from_index])
+            {
+                const Node &from = *schedule_[input->from_index].node;
+                scheduled.node->setInput(input->input, from.getOutput(input->output));
+            }
+        }
+    };
+
+    // nodes pull their inputs instead of being pushed to, so a node only writes to itself and
+    // nodes of the same level can run concurrently
+    const auto calculate_range = [this, &pull_inputs](int begin, int end) {
+        for (int index = begin; index < end; ++index)
+        {
+            const ScheduledNode &scheduled = schedule_[index];
+            Node &node = *scheduled.node;
+            node.beforeCalculate();
+            if (!scheduled.is_register)
+            {
+                pull_inputs(scheduled);
+            }
 
-        if (!is_calculated(node_id) && node.canBeCalculated())
+            if (node.canBeCalculated())
+            {
+                node.calculate();
+                parallel_calculated_[index] = true;
+            }
+        }
+    };
+
+    for (int level = 0, count = schedule_levels_.size() - 1; level < count; ++level)
+    {
+        const int begin = schedule_levels_[level];
+        const int end = schedule_levels_[level + 1];
+        if (!thread_pool_ || end - begin < MIN_PARALLEL_LEVEL_SIZE)
+        {
+            calculate_range(begin, end);
+        }
+        else
         {
-            calculate(node_id);
+            thread_pool_->parallelFor(end - begin, [&calculate_range, begin](int from, int to) {
+                calculate_range(begin + from, begin + to);
+            });
         }
     }
+
+    // nodes on a cycle
+    const int first_on_cycle = schedule_levels_.back();
+    calculate_range(first_on_cycle, schedule_.size());
+    // drivers visited after a node on a cycle reach it only now, like the pushes that come after
+    // the node in the scheduled mode; the node's output doesn't change, only its stored inputs
+    for (int index = first_on_cycle, count = schedule_.size(); index < count; ++index)
+    {
+        pull_inputs(schedule_[index]);
+    }
+
+    // registers sit on level 0, their inputs are only known now
+    for (const int index : schedule_registers_)
+    {
+        pull_inputs(schedule_[index]);
+    }
+}
+
+void Graph::latch_registers()
+{
+    for (const int id : registers_)
+    {
+        get_entry(id).node->latch();
+    }
 }
 
 std::vector<int> Graph::getNodesIds() const
 {
-    std::vector<int> ids;
-    ids.reserve(nodes_.size());
-    for (const auto &it : nodes_)
+    return nodes_.getIds();
+}
+
+std::vector<int> Graph::getEvaluationOrder()
+{
+    if (!schedule_valid_)
     {
-        ids.push_back(it.first);
+        compile_schedule();
     }
-    return ids;
+    std::vector<int> order;
+    order.reserve(schedule_.size());
+    for (const ScheduledNode &scheduled : schedule_)
+    {
+        order.push_back(scheduled.id);
+    }
+    return order;
 }
 
-std::vector<int> Graph::get_connections_from(int node_from) const
+int Graph::getNumNodesOnCycles()
 {
-    std::vector<int> connections_from;
-    for (int i = 0, count = connections_.size(); i < count; ++i)
+    if (!schedule_valid_)
     {
-        const Connection &connection = connections_[i];
-        if (connection.from == node_from)
+        compile_schedule();
+    }
+    return schedule_.size() - schedule_levels_.back();
+}
+
+std::vector<Graph::Connection> Graph::getAllConnections() const
+{
+    std::vector<Connection> connections;
+    connections.reserve(connections_.size() - free_connections_.size());
+    for (const Connection &connection : connections_)
+    {
+        if (connection.from != -1)
         {
-            connections_from.push_back(i);
+            connections.push_back(connection);
         }
     }
-    return connections_from;
+    return connections;
 }
 
-int Graph::generate_id() const
+std::vector<Graph::Connection> Graph::getOutputConnections(int node) const
 {
-    int id = 0;
-    while (nodes_.find(id) != nodes_.end())
+    std::vector<Connection> connections;
+    for (const int idx : get_entry(node).output_connections)
     {
-        ++id;
+        connections.push_back(connections_[idx]);
     }
-    return id;
+    return connections;
+}
+
+Graph::Connection Graph::getInputConnection(int node, int input) const
+{
+    const NodeEntry &entry = get_entry(node);
+    assert(input >= 0 && input < static_cast<int>(entry.input_connections.size()));
+    const int idx = entry.input_connections[input];
+    return idx == -1 ? Connection{} : connections_[idx];
+}
+
+Graph::NodeEntry &Graph::get_entry(int node)
+{
+    return nodes_.get(node);
+}
+
+const Graph::NodeEntry &Graph::get_entry(int node) const
+{
+    return nodes_.get(node);
+}
+
+void Graph::remove_connection(int idx)
+{
+    const Connection connection = connections_[idx];
+    assert(connection.from != -1);
+
+    std::vector<int> &outputs = get_entry(connection.from).output_connections;
+    const int position = output_positions_[idx];
+    assert(outputs[position] == idx);
+    outputs[position] = outputs.back();
+    output_positions_[outputs[position]] = position;
+    outputs.pop_back();
+
+    NodeEntry &to_entry = get_entry(connection.to);
+    to_entry.input_connections[connection.input] = -1;
+    --to_entry.num_connected_inputs;
+
+    connections_[idx] = Connection{};
+    free_connections_.push_back(idx);
+}
+
+void Graph::compile_schedule()
+{
+    using Slots = SlotMap<NodeEntry>;
+
+    // ordered by slot so the schedule doesn't depend on the removal history of the dense array
+    std::vector<int> ids(nodes_.getNumSlots(), -1);
+    for (const int id : nodes_.getIds())
+    {
+        ids[Slots::getSlotIndex(id)] = id;
+    }
+    ids.erase(std::remove(ids.begin(), ids.end(), -1), ids.end());
+
+    std::vector<int> num_unresolved_inputs(nodes_.getNumSlots(), 0);
+    for (const int id : ids)
+    {
+        // registers don't depend on anything within a tick
+        const NodeEntry &entry = get_entry(id);
+        num_unresolved_inputs[Slots::getSlotIndex(id)] = entry.is_register
+            ? 0
+            : entry.num_connected_inputs;
+    }
+
+    // Kahn's algorithm; the ready queue is seeded in slot order
+    std::vector<int> order;
+    order.reserve(ids.size());
+    for (const int id : ids)
+    {
+        if (num_unresolved_inputs[Slots::getSlotIndex(id)] == 0)
+        {
+            order.push_back(id);
+        }
+    }
+    // the FIFO order keeps levels (longest path from a source) non-decreasing
+    std::vector<int> levels(nodes_.getNumSlots(), 0);
+    schedule_levels_.clear();
+    // order grows inside the loop
+    for (int next = 0; next < static_cast<int>(order.size()); ++next)
+    {
+        const int level = levels[Slots::getSlotIndex(order[next])];
+        if (level == static_cast<int>(schedule_levels_.size()))
+        {
+            schedule_levels_.push_back(next);
+        }
+
+        for (const int idx : get_entry(order[next]).output_connections)
+        {
+            const int to = connections_[idx].to;
+            if (get_entry(to).is_register)
+            {
+                continue;
+            }
+            int &to_level = levels[Slots::getSlotIndex(to)];
+            to_level = std::max(to_level, level + 1);
+            if (--num_unresolved_inputs[Slots::getSlotIndex(to)] == 0)
+            {
+                order.push_back(to);
+            }
+        }
+    }
+    schedule_levels_.push_back(order.size());
+
+    // nodes on a cycle never get all their inputs, but they are still visited like before
+    for (const int id : ids)
+    {
+        if (num_unresolved_inputs[Slots::getSlotIndex(id)] > 0)
+        {
+            order.push_back(id);
+        }
+    }
+
+    std::vector<int> schedule_index(nodes_.getNumSlots(), -1);
+    for (int index = 0, count = order.size(); index < count; ++index)
+    {
+        schedule_index[Slots::getSlotIndex(order[index])] = index;
+    }
+
+    schedule_.clear();
+    schedule_connections_.clear();
+    schedule_inputs_.clear();
+    schedule_registers_.clear();
+    schedule_.reserve(order.size());
+    schedule_connections_.reserve(connections_.size() - free_connections_.size());
+    num_scheduled_outputs_ = 0;
+    for (const int id : order)
+    {
+        const NodeEntry &entry = get_entry(id);
+        Node &node = *entry.node;
+
+        ScheduledNode scheduled;
+        scheduled.id = id;
+        scheduled.node = &node;
+        scheduled.first_connection = schedule_connections_.size();
+        scheduled.first_output = num_scheduled_outputs_;
+        scheduled.is_register = entry.is_register;
+        scheduled.evaluate_every_tick = node.getNumInputs() == 0 || node.getNumOutputs() == 0
+            || entry.is_register;
+        if (entry.is_register)
+        {
+            schedule_registers_.push_back(schedule_.size());
+        }
+        num_scheduled_outputs_ += node.getNumOutputs();
+
+        for (const int idx : entry.output_connections)
+        {
+            const Connection &connection = connections_[idx];
+            ScheduledConnection scheduled_connection;
+            scheduled_connection.output = connection.output;
+            scheduled_connection.to = get_entry(connection.to).node.get();
+            scheduled_connection.to_index = schedule_index[Slots::getSlotIndex(connection.to)];
+            scheduled_connection.input = connection.input;
+            scheduled_connection.to_keeps_inputs = scheduled_connection.to->keepsInputs();
+            schedule_connections_.push_back(scheduled_connection);
+        }
+        scheduled.num_connections = schedule_connections_.size() - scheduled.first_connection;
+
+        scheduled.first_input = schedule_inputs_.size();
+        for (const int idx : entry.input_connections)
+        {
+            if (idx == -1)
+            {
+                continue;
+            }
+            const Connection &connection = connections_[idx];
+            ScheduledInput scheduled_input;
+            scheduled_input.from_index = schedule_index[Slots::getSlotIndex(connection.from)];
+            scheduled_input.output = connection.output;
+            scheduled_input.input = connection.input;
+            schedule_inputs_.push_back(scheduled_input);
+        }
+        scheduled.num_inputs = schedule_inputs_.size() - scheduled.first_input;
+
+        schedule_.push_back(scheduled);
+    }
+
+    schedule_valid_ = true;
 }
@@ -1,16 +1,62 @@
 #pragma once
 
 #include "Node.h"
+#include "SlotMap.h"
+#include "ThreadPool.h"
+#include "TickObserver.h"
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
 #include <memory>
-#include <unordered_map>
+#include <memory_resource>
 #include <vector>
 
+// Destroys nodes that Graph placed in its arena in place, deletes the others
+struct NodeDeleter
+{
+    std::pmr::memory_resource *resource{nullptr};
+    std::size_t size{0};
+    std::size_t alignment{0};
+
+    void operator()(Node *node) const
+    {
+        if (resource)
+        {
+            node->~Node();
+            resource->deallocate(node, size, alignment);
+        }
+        else
+        {
+            delete node;
+        }
+    }
+};
+
+// Owns its nodes in an arena, so a Graph can be neither copied nor moved.
 class Graph
 {
 public:
+    Graph() = default;
+    Graph(const Graph &) = delete;
+    Graph &operator=(const Graph &) = delete;
+
+    enum class EvaluationMode
+    {
+        // walk the cached topological schedule
+        Scheduled,
+        // discover the order every tick with a worklist; no schedule has to be rebuilt
+        // after structural changes
+        Worklist,
+        // recalculate only nodes whose inputs changed since the previous tick, plus registers
+        // and nodes without inputs or outputs; other nodes must be pure functions of their inputs,
+        // and nodes on cycles must not be calculable while an input is invalid (true for the
+        // built-in nodes), since they keep the inputs of the previous tick
+        Incremental,
+        // calculate the nodes of each schedule level on a thread pool, see setNumThreads()
+        Parallel,
+    };
+
     struct Connection
     {
         int from{-1};
@@ -18,6 +64,11 @@ public:
 
         int to{-1};
         int input{-1};
+
+        // what the wire carries, set by connect() from the output kind; InstructionTape keeps
+        // gates whose input wires are all bool on its bit planes
+        SignalKind kind{SignalKind::Float};
+
         bool operator==(const Connection &rhs) const
         {
             return from == rhs.from && output == rhs.output && to == rhs.to && input == rhs.input;
@@ -25,14 +76,24 @@ public:
         bool operator!=(const Connection &rhs) const { return !(rhs == *this); }
     };
 
+    // Places the node, and the buffers it allocates in its constructor, in the arena of the graph.
+    // The arena only grows: memory of removed nodes, and of nodes whose constructor threw, is
+    // released with the graph.
     template<class T, class... Args>
     int createNode(Args &&...args)
     {
-        std::unique_ptr<Node> node = std::make_unique<T>(std::forward<Args>(args)...);
-        return addNode(std::move(node));
+        void *memory = arena_.allocate(sizeof(T), alignof(T));
+        T *node;
+        {
+            const Node::BufferResourceScope scope(&arena_);
+            node = new (memory) T(std::forward<Args>(args)...);
+        }
+        return add_node(NodePtr(node, NodeDeleter{&arena_, sizeof(T), alignof(T)}));
     }
 
+    // for nodes allocated elsewhere
     int addNode(std::unique_ptr<Node> node);
+    bool hasNode(int node) const { return nodes_.contains(node); }
     Node &getNode(int node);
     const Node &getNode(int node) const;
     void removeNode(int node);
@@ -40,21 +101,147 @@ public:
     void connect(int from, int output, int to, int input);
     void disconnectInput(int node, int input);
 
+    using StopPredicate = std::function<bool(const Graph &graph)>;
+
     void iterate();
+    void run(long long num_ticks);
+    // runs until stop returns true after a tick or max_ticks were run;
+    // returns the number of ticks run
+    long long runUntil(const StopPredicate &stop, long long max_ticks);
+    // number of ticks run so far
+    long long getTick() const { return tick_; }
+
+    void addObserver(TickObserver *observer);
+    void removeObserver(TickObserver *observer);
+
+    void setEvaluationMode(EvaluationMode mode)
+    {
+        evaluation_mode_ = mode;
+        incremental_primed_ = false;
+    }
+    EvaluationMode getEvaluationMode() const { return evaluation_mode_; }
+
+    void setNumThreads(int num_threads);
+    int getNumThreads() const { return num_threads_; }
 
     std::vector<int> getNodesIds() const;
+    // ids in the order iterate() visits them: topologically sorted, then the nodes on cycles
+    std::vector<int> getEvaluationOrder();
+    int getNumNodesOnCycles();
 
-    const std::vector<Connection> &getAllConnections() const { return connections_; }
+    std::vector<Connection> getAllConnections() const;
+    std::vector<Connection> getOutputConnections(int node) const;
+    // returns an invalid connection (from == -1) if the input is not connected
+    Connection getInputConnection(int node, int input) const;
 
 private:
-    std::vector<int> get_connections_from(int node_from) const;
+    using NodePtr = std::unique_ptr<Node, NodeDeleter>;
 
-private:
-    int generate_id() const;
+    struct ScheduledConnection
+    {
+        int output{-1};
+        Node *to{nullptr};
+        int to_index{-1}; // index of the target in schedule_
+        int input{-1};
+        bool to_keeps_inputs{false}; // see Node::keepsInputs()
+    };
+
+    struct ScheduledInput
+    {
+        int from_index{-1}; // index of the driver in schedule_
+        int output{-1};
+        int input{-1};
+    };
+
+    struct ScheduledNode
+    {
+        int id{-1};
+        Node *node{nullptr};
+        int first_connection{0};
+        int num_connections{0};
+        int first_input{0};
+        int num_inputs{0};
+        int first_output{0}; // index into incremental_outputs_
+        bool evaluate_every_tick{false};
+        bool is_register{false};
+    };
+
+    struct NodeEntry
+    {
+        NodePtr node;
+        // indices into connections_
+        std::vector<int> output_connections;
+        std::vector<int> input_connections; // -1 if the input is not connected
+        int num_connected_inputs{0};
+        bool is_register{false};
+    };
+
+    void invalidate_schedule()
+    {
+        schedule_valid_ = false;
+        incremental_primed_ = false;
+    }
+    void compile_schedule();
+
+    long long run_ticks(long long max_ticks, const StopPredicate *stop);
+    template<class Iterate>
+    long long run_loop(long long max_ticks, const StopPredicate *stop, Iterate iterate);
+
+    void iterate_scheduled();
+    void iterate_worklist();
+    void iterate_incremental();
+    void iterate_parallel();
+    void latch_registers();
+
+    int add_node(NodePtr node);
+
+    NodeEntry &get_entry(int node);
+    const NodeEntry &get_entry(int node) const;
+
+    void remove_connection(int idx);
 
 private:
-    std::unordered_map<int, std::unique_ptr<Node>> nodes_;
+    // nodes and their buffers in creation order; declared first so it outlives them
+    std::pmr::monotonic_buffer_resource arena_;
+    SlotMap<NodeEntry> nodes_;
+    std::vector<int> registers_;
+
+    // removed connections leave holes (from == -1) that are reused by connect()
     std::vector<Connection> connections_;
+    std::vector<int> free_connections_;
+    // where each connection sits in the output_connections of its driver, for O(1) removal
+    std::vector<int> output_positions_;
+
+    // topologically sorted nodes, rebuilt only after structural changes
+    std::vector<ScheduledNode> schedule_;
+    std::vector<ScheduledConnection> schedule_connections_;
+    std::vector<ScheduledInput> schedule_inputs_;
+    std::vector<int> schedule_registers_; // indices into schedule_
+    // schedule_levels_[i] is the index of the first node of level i in schedule_; the last
+    // element is where the unsorted nodes on cycles start
+    std::vector<int> schedule_levels_;
+    int num_scheduled_outputs_{0};
+    bool schedule_valid_{false};
+
+    EvaluationMode evaluation_mode_{EvaluationMode::Scheduled};
+    long long tick_{0};
+    std::vector<TickObserver *> observers_;
+
+    // scratch buffers of iterate_worklist(), indexed by slot
+    std::vector<int> num_pending_inputs_;
+    std::vector<int> worklist_;
+
+    // state of iterate_incremental(), indexed like schedule_
+    bool incremental_primed_{false};
+    std::vector<Signal> incremental_outputs_;
+    std::vector<char> incremental_dirty_;
+    std::vector<Signal> incremental_inputs_; // scratch for nodes that can't be calculated
+
+    // levels smaller than this are not worth waking the workers up
+    static constexpr int MIN_PARALLEL_LEVEL_SIZE = 256;
+    int num_threads_{1};
+    std::unique_ptr<ThreadPool> thread_pool_;
+    std::vector<char> parallel_calculated_; // indexed like schedule_
 };
 
 inline std::ostream &operator<<(std::ostream &os, const Graph &graph)
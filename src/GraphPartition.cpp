@@ -0,0 +1,376 @@
+#include "GraphPartition.h"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <queue>
+#include <random>
+
+namespace
+{
+
+// coarsening stops at this many vertices per part
+constexpr int COARSEST_VERTICES_PER_PART = 20;
+// or when a level shrinks less than this
+constexpr float MIN_COARSENING_RATIO = 0.9f;
+constexpr int MAX_REFINEMENT_PASSES = 8;
+
+// Undirected graph in compressed rows: the neighbors of v are edges[first_edges[v]] up to
+// edges[first_edges[v + 1]]. Parallel edges are merged into one of larger weight.
+struct Level
+{
+    std::vector<int> first_edges{0};
+    std::vector<int> edges;
+    std::vector<int> edge_weights;
+    std::vector<int> vertex_weights;
+    // the vertex of the next coarser level every vertex was merged into
+    std::vector<int> coarse_vertices;
+
+    int getNumVertices() const { return vertex_weights.size(); }
+};
+
+// appends a row to level, merging the edges to the same neighbor; positions is scratch space
+// with one -1 per vertex of level
+void add_row(Level &level, int vertex, int weight,
+    const std::vector<std::pair<int, int>> &neighbors, std::vector<int> &positions)
+{
+    const int first = level.edges.size();
+    for (const auto &[neighbor, edge_weight] : neighbors)
+    {
+        if (neighbor == vertex)
+        {
+            continue;
+        }
+        if (positions[neighbor] >= first)
+        {
+            level.edge_weights[positions[neighbor]] += edge_weight;
+            continue;
+        }
+        positions[neighbor] = level.edges.size();
+        level.edges.push_back(neighbor);
+        level.edge_weights.push_back(edge_weight);
+    }
+    level.first_edges.push_back(level.edges.size());
+    level.vertex_weights.push_back(weight);
+}
+
+// merges every vertex with the unmatched neighbor it shares the heaviest edge with
+Level coarsen(Level &fine, std::mt19937 &rng)
+{
+    const int num_vertices = fine.getNumVertices();
+    std::vector<int> order(num_vertices);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<int> matches(num_vertices, -1);
+    for (const int vertex : order)
+    {
+        if (matches[vertex] != -1)
+        {
+            continue;
+        }
+        int best = vertex;
+        int best_weight = 0;
+        for (int e = fine.first_edges[vertex]; e < fine.first_edges[vertex + 1]; ++e)
+        {
+            const int neighbor = fine.edges[e];
+            if (matches[neighbor] == -1 && fine.edge_weights[e] > best_weight)
+            {
+                best = neighbor;
+                best_weight = fine.edge_weights[e];
+            }
+        }
+        matches[vertex] = best;
+        matches[best] = vertex;
+    }
+
+    fine.coarse_vertices.assign(num_vertices, -1);
+    int num_coarse = 0;
+    for (int vertex = 0; vertex < num_vertices; ++vertex)
+    {
+        if (fine.coarse_vertices[vertex] == -1)
+        {
+            fine.coarse_vertices[vertex] = num_coarse;
+            fine.coarse_vertices[matches[vertex]] = num_coarse;
+            ++num_coarse;
+        }
+    }
+
+    Level coarse;
+    std::vector<int> positions(num_coarse, -1);
+    std::vector<std::pair<int, int>> neighbors;
+    for (int vertex = 0; vertex < num_vertices; ++vertex)
+    {
+        const int match = matches[vertex];
+        if (match < vertex)
+        {
+            continue;
+        }
+        int weight = 0;
+        neighbors.clear();
+        const auto add_member = [&](int member) {
+            weight += fine.vertex_weights[member];
+            for (int e = fine.first_edges[member]; e < fine.first_edges[member + 1]; ++e)
+            {
+                neighbors.emplace_back(fine.coarse_vertices[fine.edges[e]], fine.edge_weights[e]);
+            }
+        };
+        add_member(vertex);
+        if (match != vertex)
+        {
+            add_member(match);
+        }
+        const int coarse_vertex = fine.coarse_vertices[vertex];
+        add_row(coarse, coarse_vertex, weight, neighbors, positions);
+    }
+    return coarse;
+}
+
+// grows the parts one after another from a seed, always adding the vertex most connected to
+// the part; what is left goes to the last part
+std::vector<int> grow_parts(const Level &level, int num_parts)
+{
+    const int num_vertices = level.getNumVertices();
+    const int total_weight =
+        std::accumulate(level.vertex_weights.begin(), level.vertex_weights.end(), 0);
+
+    std::vector<int> parts(num_vertices, -1);
+    std::vector<int> connections(num_vertices, 0);
+    int next_seed = 0;
+    int assigned_weight = 0;
+    for (int part = 0; part + 1 < num_parts; ++part)
+    {
+        // spread the rounding over the parts
+        const int target = static_cast<long long>(total_weight) * (part + 1) / num_parts;
+
+        std::priority_queue<std::pair<int, int>> queue; // connection, vertex
+        std::vector<int> touched;
+        while (assigned_weight < target)
+        {
+            if (queue.empty())
+            {
+                while (next_seed < num_vertices && parts[next_seed] != -1)
+                {
+                    ++next_seed;
+                }
+                if (next_seed == num_vertices)
+                {
+                    break;
+                }
+                queue.emplace(0, next_seed);
+            }
+
+            const auto [connection, vertex] = queue.top();
+            queue.pop();
+            if (parts[vertex] != -1 || connection != connections[vertex])
+            {
+                continue;
+            }
+            parts[vertex] = part;
+            assigned_weight += level.vertex_weights[vertex];
+
+            for (int e = level.first_edges[vertex]; e < level.first_edges[vertex + 1]; ++e)
+            {
+                const int neighbor = level.edges[e];
+                if (parts[neighbor] == -1)
+                {
+                    connections[neighbor] += level.edge_weights[e];
+                    touched.push_back(neighbor);
+                    queue.emplace(connections[neighbor], neighbor);
+                }
+            }
+        }
+        for (const int vertex : touched)
+        {
+            connections[vertex] = 0;
+        }
+    }
+
+    for (int &part : parts)
+    {
+        if (part == -1)
+        {
+            part = num_parts - 1;
+        }
+    }
+    return parts;
+}
+
+// Moves boundary vertices to the neighboring part they are most connected to while that cuts
+// fewer edges and keeps the parts under max_weight. Moves that don't change the cut are taken
+// when they even out the weights, and overweight parts give vertices away at any cost.
+void refine(const Level &level, int num_parts, int max_weight, std::vector<int> &parts)
+{
+    const int num_vertices = level.getNumVertices();
+    std::vector<int> part_weights(num_parts, 0);
+    for (int vertex = 0; vertex < num_vertices; ++vertex)
+    {
+        part_weights[parts[vertex]] += level.vertex_weights[vertex];
+    }
+
+    std::vector<int> part_connections(num_parts, 0);
+    std::vector<int> touched;
+    for (int pass = 0; pass < MAX_REFINEMENT_PASSES; ++pass)
+    {
+        int num_moves = 0;
+        for (int vertex = 0; vertex < num_vertices; ++vertex)
+        {
+            const int from = parts[vertex];
+            const int weight = level.vertex_weights[vertex];
+
+            touched.clear();
+            for (int e = level.first_edges[vertex]; e < level.first_edges[vertex + 1]; ++e)
+            {
+                const int part = parts[level.edges[e]];
+                if (part_connections[part] == 0)
+                {
+                    touched.push_back(part);
+                }
+                part_connections[part] += level.edge_weights[e];
+            }
+
+            const bool overweight = part_weights[from] > max_weight;
+            if (overweight)
+            {
+                const int lightest = std::min_element(part_weights.begin(), part_weights.end())
+                    - part_weights.begin();
+                if (part_connections[lightest] == 0)
+                {
+                    touched.push_back(lightest);
+                }
+            }
+
+            int best = from;
+            int best_gain = 0;
+            for (const int part : touched)
+            {
+                if (part == from || part_weights[part] + weight > max_weight)
+                {
+                    continue;
+                }
+                const int gain = part_connections[part] - part_connections[from];
+                const bool evens_out = part_weights[part] + weight < part_weights[from];
+                if ((best == from && (gain > 0 || (gain == 0 && evens_out) || overweight))
+                    || (best != from && gain > best_gain))
+                {
+                    best = part;
+                    best_gain = gain;
+                }
+            }
+
+            for (const int part : touched)
+            {
+                part_connections[part] = 0;
+            }
+            part_connections[from] = 0;
+
+            if (best != from)
+            {
+                parts[vertex] = best;
+                part_weights[from] -= weight;
+                part_weights[best] += weight;
+                ++num_moves;
+            }
+        }
+        if (num_moves == 0)
+        {
+            break;
+        }
+    }
+}
+
+} // namespace
+
+int GraphPartition::getPart(int node) const
+{
+    const auto it = node_parts.find(node);
+    assert(it != node_parts.end());
+    return it->second;
+}
+
+std::vector<std::vector<int>> GraphPartition::getParts(const Graph &graph) const
+{
+    std::vector<std::vector<int>> parts(num_parts);
+    for (const int id : graph.getNodesIds())
+    {
+        parts[getPart(id)].push_back(id);
+    }
+    return parts;
+}
+
+GraphPartition partitionGraph(const Graph &graph, int num_parts, float max_imbalance)
+{
+    assert(num_parts >= 1 && max_imbalance >= 0.0f);
+
+    const std::vector<int> ids = graph.getNodesIds();
+    const std::vector<Graph::Connection> connections = graph.getAllConnections();
+    const int num_vertices = ids.size();
+
+    std::unordered_map<int, int> vertices;
+    for (int vertex = 0; vertex < num_vertices; ++vertex)
+    {
+        vertices[ids[vertex]] = vertex;
+    }
+
+    std::vector<std::vector<std::pair<int, int>>> neighbors(num_vertices);
+    for (const Graph::Connection &connection : connections)
+    {
+        const int from = vertices[connection.from];
+        const int to = vertices[connection.to];
+        neighbors[from].emplace_back(to, 1);
+        neighbors[to].emplace_back(from, 1);
+    }
+
+    std::vector<Level> levels(1);
+    std::vector<int> positions(num_vertices, -1);
+    for (int vertex = 0; vertex < num_vertices; ++vertex)
+    {
+        add_row(levels[0], vertex, 1, neighbors[vertex], positions);
+    }
+    neighbors.clear();
+
+    std::mt19937 rng(num_parts);
+    while (levels.back().getNumVertices() > COARSEST_VERTICES_PER_PART * num_parts)
+    {
+        Level coarse = coarsen(levels.back(), rng);
+        if (coarse.getNumVertices() > MIN_COARSENING_RATIO * levels.back().getNumVertices())
+        {
+            levels.back().coarse_vertices.clear();
+            break;
+        }
+        levels.push_back(std::move(coarse));
+    }
+
+    const int average_weight = (num_vertices + num_parts - 1) / num_parts;
+    const int max_weight = average_weight + static_cast<int>(average_weight * max_imbalance);
+    std::vector<int> parts = grow_parts(levels.back(), num_parts);
+    refine(levels.back(), num_parts, max_weight, parts);
+    for (int level = levels.size() - 2; level >= 0; --level)
+    {
+        const Level &fine = levels[level];
+        std::vector<int> fine_parts(fine.getNumVertices());
+        for (int vertex = 0; vertex < fine.getNumVertices(); ++vertex)
+        {
+            fine_parts[vertex] = parts[fine.coarse_vertices[vertex]];
+        }
+        parts = std::move(fine_parts);
+        refine(fine, num_parts, max_weight, parts);
+    }
+
+    GraphPartition partition;
+    partition.num_parts = num_parts;
+    partition.part_sizes.assign(num_parts, 0);
+    for (int vertex = 0; vertex < num_vertices; ++vertex)
+    {
+        partition.node_parts[ids[vertex]] = parts[vertex];
+        ++partition.part_sizes[parts[vertex]];
+    }
+    for (const Graph::Connection &connection : connections)
+    {
+        if (parts[vertices[connection.from]] != parts[vertices[connection.to]])
+        {
+            ++partition.num_cut_connections;
+        }
+    }
+    return partition;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Assignment of every node of a graph to one of num_parts parts
+struct GraphPartition
+{
+    int num_parts{0};
+    std::unordered_map<int, int> node_parts;
+    std::vector<int> part_sizes; // nodes per part
+    int num_cut_connections{0};  // connections between nodes of different parts
+
+    int getPart(int node) const;
+    // node ids of every part, in getNodesIds() order
+    std::vector<std::vector<int>> getParts(const Graph &graph) const;
+};
+
+// Splits the nodes into num_parts parts of at most (1 + max_imbalance) times the average size
+// while keeping few connections between parts. Multilevel scheme: the connection graph is
+// coarsened by heavy-edge matching, the coarsest graph is split by greedy region growing, and the
+// split is projected back level by level with a boundary refinement pass on each.
+//
+// Deterministic for a given graph.
+GraphPartition partitionGraph(const Graph &graph, int num_parts, float max_imbalance = 0.05f);
@@ -0,0 +1,836 @@
+#include "GraphPasses.h"
+
+#include "AndInverterGraph.h"
+#include "Nodes.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+
+// nodes that output a pure function of their inputs
+bool is_foldable(const Node &node)
+{
+    return object_cast<AndNode>(&node) || object_cast<OrNode>(&node)
+        || object_cast<XorNode>(&node) || object_cast<NotNode>(&node)
+        || object_cast<NegateNode>(&node) || object_cast<ReciprocalNode>(&node)
+        || object_cast<SumNode>(&node) || object_cast<MultiplicationNode>(&node);
+}
+
+bool is_gate(const Node &node)
+{
+    return object_cast<AndNode>(&node) || object_cast<OrNode>(&node)
+        || object_cast<XorNode>(&node) || object_cast<NotNode>(&node);
+}
+
+// Chooses the gates that compute the literals of an AndInverterGraph needed outside of it
+class GateMapper
+{
+public:
+    using Aig = AndInverterGraph;
+    using Literal = Aig::Literal;
+
+    enum class Form
+    {
+        None,
+        Input, // the driver of an AIG input, no gate
+        Not,
+        And,
+        Or,
+        Xor,
+    };
+
+    GateMapper(const Aig &aig, const std::vector<Literal> &roots)
+        : aig_(aig)
+        , forms_(aig.getNumNodes() * 2, Form::None)
+        , terms_(aig.getNumNodes() * 2)
+        , refs_(aig.getNumNodes(), 0)
+    {
+        std::vector<char> reachable(aig.getNumNodes(), false);
+        for (const Literal root : roots)
+        {
+            reachable[Aig::getNode(root)] = true;
+            ++refs_[Aig::getNode(root)];
+        }
+        for (int node = aig.getNumNodes() - 1; node >= 0; --node)
+        {
+            if (reachable[node] && !aig.isInput(node))
+            {
+                for (const Literal fanin : {aig.getFanin0(node), aig.getFanin1(node)})
+                {
+                    reachable[Aig::getNode(fanin)] = true;
+                    ++refs_[Aig::getNode(fanin)];
+                }
+            }
+        }
+
+        std::vector<char> needed(aig.getNumNodes() * 2, false);
+        for (const Literal root : roots)
+        {
+            needed[root] = true;
+        }
+        // users have larger indices, so all uses of a node are known when it is reached. Of the
+        // two literals of a node the one that may be built as a NOT of the other goes first: the
+        // XNOR of an XOR, the inverted literal of anything else
+        for (int node = aig.getNumNodes() - 1; node >= 0; --node)
+        {
+            Literal a, b;
+            const bool xnor_first = !aig.isInput(node) && is_xor(node, a, b);
+            for (const bool inverted : {!xnor_first, xnor_first})
+            {
+                const Literal literal = Aig::makeLiteral(node, inverted);
+                if (!needed[literal])
+                {
+                    continue;
+                }
+                choose(literal);
+                order_.push_back(literal);
+                for (const Literal term : terms_[literal])
+                {
+                    needed[term] = true;
+                }
+            }
+        }
+        std::reverse(order_.begin(), order_.end());
+    }
+
+    // the chosen literals, each after its terms
+    const std::vector<Literal> &getOrder() const { return order_; }
+
+    Form getForm(Literal literal) const { return forms_[literal]; }
+    const std::vector<Literal> &getTerms(Literal literal) const { return terms_[literal]; }
+
+    int getNumGates() const
+    {
+        return std::count_if(forms_.begin(), forms_.end(),
+            [](Form form) { return form != Form::None && form != Form::Input; });
+    }
+
+private:
+    void choose(Literal literal)
+    {
+        const int node = Aig::getNode(literal);
+        std::vector<Literal> &terms = terms_[literal];
+
+        if (aig_.isInput(node))
+        {
+            forms_[literal] = Aig::isInverted(literal) ? Form::Not : Form::Input;
+            if (Aig::isInverted(literal))
+            {
+                terms.push_back(Aig::invert(literal));
+            }
+            return;
+        }
+
+        Literal a, b;
+        if (is_xor(node, a, b))
+        {
+            // an XNOR is the inverse of the XOR
+            forms_[literal] = Aig::isInverted(literal) ? Form::Xor : Form::Not;
+            if (Aig::isInverted(literal))
+            {
+                flatten_xor(node, terms);
+            }
+            else
+            {
+                terms.push_back(Aig::invert(literal));
+            }
+            return;
+        }
+
+        if (!Aig::isInverted(literal))
+        {
+            forms_[literal] = Form::And;
+            flatten(node, false, terms);
+            return;
+        }
+
+        // !(x & y) == !x | !y, unless that needs more inverters than it saves
+        flatten(node, true, terms);
+        const int num_inverted = std::count_if(terms.begin(), terms.end(), Aig::isInverted);
+        if (num_inverted * 2 > static_cast<int>(terms.size()))
+        {
+            forms_[literal] = Form::Not;
+            terms = {Aig::invert(literal)};
+            return;
+        }
+        forms_[literal] = Form::Or;
+    }
+
+    // the terms of a wide AND of node, or of a wide OR of its inverse; fanins used only here are
+    // merged into the same gate
+    void flatten(int node, bool inverse, std::vector<Literal> &terms) const
+    {
+        std::vector<Literal> stack{aig_.getFanin1(node), aig_.getFanin0(node)};
+        while (!stack.empty())
+        {
+            const Literal fanin = stack.back();
+            stack.pop_back();
+
+            const int fanin_node = Aig::getNode(fanin);
+            Literal a, b;
+            if (!Aig::isInverted(fanin) && !aig_.isInput(fanin_node) && refs_[fanin_node] == 1
+                && !is_xor(fanin_node, a, b))
+            {
+                stack.push_back(aig_.getFanin1(fanin_node));
+                stack.push_back(aig_.getFanin0(fanin_node));
+                continue;
+            }
+            terms.push_back(inverse ? Aig::invert(fanin) : fanin);
+        }
+    }
+
+    // the terms of a wide XOR that equals !node; an inverted term costs an inverter, and every
+    // two of them cancel out
+    void flatten_xor(int node, std::vector<Literal> &terms) const
+    {
+        bool inverted = false;
+        std::vector<int> stack{node};
+        while (!stack.empty())
+        {
+            Literal a = 0, b = 0;
+            is_xor(stack.back(), a, b);
+            stack.pop_back();
+            for (const Literal term : {b, a})
+            {
+                // both halves of the XOR use the term, nothing else may
+                const int term_node = Aig::getNode(term);
+                Literal c, d;
+                if (!aig_.isInput(term_node) && refs_[term_node] == 2 && is_xor(term_node, c, d))
+                {
+                    // term is the XOR of term_node or its inverse
+                    inverted ^= !Aig::isInverted(term);
+                    stack.push_back(term_node);
+                    continue;
+                }
+                inverted ^= Aig::isInverted(term);
+                terms.push_back(Aig::makeLiteral(term_node));
+            }
+        }
+        if (inverted)
+        {
+            terms[0] = Aig::invert(terms[0]);
+        }
+    }
+
+    // !node == a ^ b, as built by AndInverterGraph::makeXor()
+    bool is_xor(int node, Literal &a, Literal &b) const
+    {
+        const Literal fanin0 = aig_.getFanin0(node);
+        const Literal fanin1 = aig_.getFanin1(node);
+        if (!Aig::isInverted(fanin0) || !Aig::isInverted(fanin1))
+        {
+            return false;
+        }
+        const int x = Aig::getNode(fanin0);
+        const int y = Aig::getNode(fanin1);
+        if (aig_.isInput(x) || aig_.isInput(y) || refs_[x] != 1 || refs_[y] != 1)
+        {
+            return false;
+        }
+
+        const Literal p = aig_.getFanin0(x);
+        const Literal q = aig_.getFanin1(x);
+        const Literal not_r = Aig::invert(aig_.getFanin0(y));
+        const Literal not_s = Aig::invert(aig_.getFanin1(y));
+        if (!((p == not_r && q == not_s) || (p == not_s && q == not_r)))
+        {
+            return false;
+        }
+
+        // !(!(p & q) & !(!p & !q)) == p ^ !q == !p ^ q
+        a = Aig::isInverted(q) ? p : Aig::invert(p);
+        b = Aig::isInverted(q) ? Aig::invert(q) : q;
+        return true;
+    }
+
+private:
+    const Aig &aig_;
+    std::vector<Form> forms_;                // indexed by literal
+    std::vector<std::vector<Literal>> terms_; // indexed by literal
+    std::vector<int> refs_;                  // indexed by node
+    std::vector<Literal> order_;
+};
+
+struct Term
+{
+    int node{-1};
+    int output{0};
+    bool negated{false};
+};
+
+// connects the consumers of node to source instead
+void replace_uses(Graph &graph, int node, int source, int output)
+{
+    for (const Graph::Connection &connection : graph.getOutputConnections(node))
+    {
+        graph.connect(source, output, connection.to, connection.input);
+    }
+}
+
+// creates a T in the arena of graph that takes the name of node and is driven by terms
+template<class T, class... Args>
+int create_replacement(Graph &graph, int node, const std::vector<Term> &terms, Args &&...args)
+{
+    const int created = graph.createNode<T>(std::forward<Args>(args)...);
+    graph.getNode(created).setName(graph.getNode(node).getName());
+    for (int input = 0, count = terms.size(); input < count; ++input)
+    {
+        graph.connect(terms[input].node, terms[input].output, created, input);
+    }
+    return created;
+}
+
+bool has_unconnected_inputs(const Graph &graph, int node)
+{
+    for (int input = 0, count = graph.getNode(node).getNumInputs(); input < count; ++input)
+    {
+        if (graph.getInputConnection(node, input).from == -1)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+OptimizationReport foldConstants(Graph &graph, const std::vector<int> &keep)
+{
+    OptimizationReport report;
+    const std::unordered_set<int> kept(keep.begin(), keep.end());
+
+    const std::vector<int> order = graph.getEvaluationOrder();
+    const int num_sorted = order.size() - graph.getNumNodesOnCycles();
+
+    // outputs of the constants and of the nodes folded so far
+    std::unordered_map<int, Signal> constants;
+    for (int i = 0; i < num_sorted; ++i)
+    {
+        const int id = order[i];
+        Node &node = graph.getNode(id);
+        if (object_cast<ConstantNode>(&node))
+        {
+            constants[id] = node.getOutput(0);
+            continue;
+        }
+        if (!is_foldable(node) || kept.count(id))
+        {
+            continue;
+        }
+
+        std::vector<Signal> inputs;
+        bool all_constant = true;
+        for (int input = 0, count = node.getNumInputs(); input < count && all_constant; ++input)
+        {
+            const int from = graph.getInputConnection(id, input).from;
+            if (from == -1)
+            {
+                // stays invalid, like in Graph::iterate()
+                inputs.push_back(Signal::INVALID());
+                continue;
+            }
+            const auto it = constants.find(from);
+            all_constant = it != constants.end();
+            if (all_constant)
+            {
+                inputs.push_back(it->second);
+            }
+        }
+        if (!all_constant)
+        {
+            continue;
+        }
+
+        node.beforeCalculate();
+        for (int input = 0, count = inputs.size(); input < count; ++input)
+        {
+            node.setInput(input, inputs[input]);
+        }
+        if (!node.canBeCalculated())
+        {
+            continue;
+        }
+        node.calculate();
+
+        constants[id] = node.getOutput(0);
+        report.folded_nodes.push_back(id);
+    }
+
+    const std::unordered_set<int> folded(report.folded_nodes.begin(), report.folded_nodes.end());
+    for (const int id : report.folded_nodes)
+    {
+        // a folded node that only drives folded nodes needs no constant
+        std::vector<Graph::Connection> consumers;
+        for (const Graph::Connection &connection : graph.getOutputConnections(id))
+        {
+            if (!folded.count(connection.to))
+            {
+                consumers.push_back(connection);
+            }
+        }
+        if (consumers.empty())
+        {
+            continue;
+        }
+
+        const int constant = graph.createNode<ConstantNode>(constants[id]);
+        graph.getNode(constant).setName(graph.getNode(id).getName());
+        for (const Graph::Connection &connection : consumers)
+        {
+            graph.connect(constant, 0, connection.to, connection.input);
+        }
+        report.added_nodes.push_back(constant);
+    }
+
+    for (const int id : report.folded_nodes)
+    {
+        graph.removeNode(id);
+    }
+    return report;
+}
+
+OptimizationReport strashBooleanLogic(Graph &graph, const std::vector<int> &keep)
+{
+    using Aig = AndInverterGraph;
+    using Literal = Aig::Literal;
+    using Form = GateMapper::Form;
+
+    OptimizationReport report;
+    const std::unordered_set<int> kept(keep.begin(), keep.end());
+
+    const std::vector<int> order = graph.getEvaluationOrder();
+    const int num_sorted = order.size() - graph.getNumNodesOnCycles();
+
+    struct Source
+    {
+        int node{-1};
+        int output{0};
+    };
+
+    Aig aig;
+    std::map<std::pair<int, int>, Literal> input_literals;
+    std::vector<Source> input_sources; // indexed by AIG node
+    std::unordered_map<int, Literal> gate_literals;
+    std::vector<int> gates;
+
+    for (int i = 0; i < num_sorted; ++i)
+    {
+        const int id = order[i];
+        const Node &node = graph.getNode(id);
+        const int num_inputs = node.getNumInputs();
+        if (!is_gate(node) || kept.count(id) || num_inputs == 0)
+        {
+            continue;
+        }
+
+        std::vector<Literal> inputs;
+        for (int input = 0; input < num_inputs; ++input)
+        {
+            const Graph::Connection connection = graph.getInputConnection(id, input);
+            if (connection.from == -1)
+            {
+                break;
+            }
+            const auto gate = gate_literals.find(connection.from);
+            if (gate != gate_literals.end())
+            {
+                inputs.push_back(gate->second);
+                continue;
+            }
+
+            const auto key = std::make_pair(connection.from, connection.output);
+            auto it = input_literals.find(key);
+            if (it == input_literals.end())
+            {
+                it = input_literals.emplace(key, aig.addInput()).first;
+                input_sources.resize(aig.getNumNodes());
+                input_sources.back() = {connection.from, connection.output};
+            }
+            inputs.push_back(it->second);
+        }
+        // an unconnected input keeps the gate from ever being calculated, leave it alone
+        if (static_cast<int>(inputs.size()) != num_inputs)
+        {
+            continue;
+        }
+
+        Literal literal = inputs[0];
+        for (int input = 1; input < num_inputs; ++input)
+        {
+            if (object_cast<AndNode>(&node))
+            {
+                literal = aig.makeAnd(literal, inputs[input]);
+            }
+            else if (object_cast<OrNode>(&node))
+            {
+                literal = aig.makeOr(literal, inputs[input]);
+            }
+            else
+            {
+                literal = aig.makeXor(literal, inputs[input]);
+            }
+        }
+        if (object_cast<NotNode>(&node))
+        {
+            literal = Aig::invert(literal);
+        }
+
+        gate_literals[id] = literal;
+        gates.push_back(id);
+    }
+
+    // gates whose output leaves the logic, and gates without any consumer
+    std::vector<int> roots;
+    std::vector<Literal> root_literals;
+    for (const int id : gates)
+    {
+        const std::vector<Graph::Connection> connections = graph.getOutputConnections(id);
+        const bool is_root = connections.empty()
+            || std::any_of(connections.begin(), connections.end(),
+                [&](const Graph::Connection &connection) {
+                    return !gate_literals.count(connection.to);
+                });
+        if (is_root)
+        {
+            roots.push_back(id);
+            root_literals.push_back(gate_literals[id]);
+        }
+    }
+
+    const GateMapper mapper(aig, root_literals);
+    // a root that is an AIG input still needs a gate to turn its value into a bool
+    std::unordered_set<Literal> buffered;
+    for (const Literal literal : root_literals)
+    {
+        if (mapper.getForm(literal) == Form::Input)
+        {
+            buffered.insert(literal);
+        }
+    }
+    if (mapper.getNumGates() + static_cast<int>(buffered.size()) >= static_cast<int>(gates.size()))
+    {
+        return report;
+    }
+
+    std::vector<Source> sources(aig.getNumNodes() * 2);
+    for (const Literal literal : mapper.getOrder())
+    {
+        const Form form = mapper.getForm(literal);
+        if (form == Form::Input)
+        {
+            sources[literal] = input_sources[Aig::getNode(literal)];
+            continue;
+        }
+
+        const std::vector<Literal> &terms = mapper.getTerms(literal);
+        int gate = -1;
+        switch (form)
+        {
+        case Form::Not: gate = graph.createNode<NotNode>(); break;
+        case Form::And: gate = graph.createNode<AndNode>(terms.size()); break;
+        case Form::Or: gate = graph.createNode<OrNode>(terms.size()); break;
+        case Form::Xor: gate = graph.createNode<XorNode>(terms.size()); break;
+        case Form::None:
+        case Form::Input: assert(false); break;
+        }
+        for (int input = 0, num_inputs = terms.size(); input < num_inputs; ++input)
+        {
+            const Source &source = sources[terms[input]];
+            graph.connect(source.node, source.output, gate, input);
+        }
+        sources[literal] = {gate, 0};
+        report.added_nodes.push_back(gate);
+    }
+
+    std::unordered_set<Literal> named;
+    for (int i = 0, count = roots.size(); i < count; ++i)
+    {
+        const int root = roots[i];
+        const Literal literal = root_literals[i];
+        if (buffered.count(literal) && named.count(literal) == 0)
+        {
+            const Source &source = sources[literal];
+            const int gate = graph.createNode<AndNode>(1);
+            graph.connect(source.node, source.output, gate, 0);
+            sources[literal] = {gate, 0};
+            report.added_nodes.push_back(gate);
+        }
+        const Source &source = sources[literal];
+        if (named.insert(literal).second)
+        {
+            graph.getNode(source.node).setName(graph.getNode(root).getName());
+        }
+
+        for (const Graph::Connection &connection : graph.getOutputConnections(root))
+        {
+            if (!gate_literals.count(connection.to))
+            {
+                graph.connect(source.node, source.output, connection.to, connection.input);
+            }
+        }
+    }
+
+    for (const int id : gates)
+    {
+        graph.removeNode(id);
+    }
+    report.rewritten_nodes = std::move(gates);
+    return report;
+}
+
+OptimizationReport simplifyArithmetic(Graph &graph, const std::vector<int> &keep)
+{
+    OptimizationReport report;
+    const std::unordered_set<int> kept(keep.begin(), keep.end());
+
+    const std::vector<int> order = graph.getEvaluationOrder();
+    const int num_sorted = order.size() - graph.getNumNodesOnCycles();
+
+    // nodes whose output is valid every tick, for the rule that turns x * 0 into a constant
+    std::unordered_set<int> always_valid;
+    const auto update_always_valid = [&](int id) {
+        const Node &node = graph.getNode(id);
+        bool valid = object_cast<TriangleSignalNode>(&node)
+            || (object_cast<ConstantNode>(&node) && node.getOutput(0).isValid());
+        if (is_foldable(node) || object_cast<SubtractionNode>(&node))
+        {
+            valid = true;
+            for (int input = 0, count = node.getNumInputs(); input < count && valid; ++input)
+            {
+                valid = always_valid.count(graph.getInputConnection(id, input).from) > 0;
+            }
+        }
+        if (valid)
+        {
+            always_valid.insert(id);
+        }
+    };
+
+    // a node can be merged into its only consumer
+    const auto is_mergeable = [&](int id) {
+        return !kept.count(id) && graph.getOutputConnections(id).size() == 1
+            && !has_unconnected_inputs(graph, id);
+    };
+    const auto replace = [&](int id, int source, int output, const std::vector<int> &merged) {
+        replace_uses(graph, id, source, output);
+        graph.removeNode(id);
+        report.rewritten_nodes.push_back(id);
+        for (const int merged_id : merged)
+        {
+            graph.removeNode(merged_id);
+            report.rewritten_nodes.push_back(merged_id);
+        }
+    };
+    const auto add = [&](int added) {
+        report.added_nodes.push_back(added);
+        update_always_valid(added);
+        return added;
+    };
+
+    for (int i = 0; i < num_sorted; ++i)
+    {
+        const int id = order[i];
+        if (!graph.hasNode(id))
+        {
+            continue;
+        }
+        update_always_valid(id);
+        if (kept.count(id) || has_unconnected_inputs(graph, id))
+        {
+            continue;
+        }
+        const Node &node = graph.getNode(id);
+
+        if (object_cast<NegateNode>(&node) || object_cast<ReciprocalNode>(&node))
+        {
+            const int inner = graph.getInputConnection(id, 0).from;
+            const Node &inner_node = graph.getNode(inner);
+            if (inner_node.getType() != node.getType() || has_unconnected_inputs(graph, inner))
+            {
+                continue;
+            }
+            const Graph::Connection source = graph.getInputConnection(inner, 0);
+            replace(id, source.from, source.output,
+                is_mergeable(inner) ? std::vector<int>{inner} : std::vector<int>{});
+            continue;
+        }
+
+        const bool is_sum = object_cast<SumNode>(&node) || object_cast<SubtractionNode>(&node);
+        const bool is_product = object_cast<MultiplicationNode>(&node);
+        if (!is_sum && !is_product)
+        {
+            continue;
+        }
+
+        // the terms of node in input order, merging the nodes that only feed it
+        std::vector<Term> terms;
+        std::vector<int> merged;
+        bool changed = false;
+        bool never_valid = false;
+        bool zero = false;
+
+        const auto push_inputs = [&graph](int node, bool negated, std::vector<Term> &stack) {
+            const auto *subtraction = object_cast<SubtractionNode>(&graph.getNode(node));
+            for (int input = graph.getNode(node).getNumInputs() - 1; input >= 0; --input)
+            {
+                const Graph::Connection connection = graph.getInputConnection(node, input);
+                const bool subtracted = subtraction && subtraction->isSubtracted(input);
+                stack.push_back({connection.from, connection.output, negated != subtracted});
+            }
+        };
+        std::vector<Term> stack;
+        push_inputs(id, false, stack);
+        while (!stack.empty())
+        {
+            const Term term = stack.back();
+            stack.pop_back();
+            const Node &from = graph.getNode(term.node);
+
+            if (object_cast<ConstantNode>(&from))
+            {
+                const Signal value = from.getOutput(0);
+                never_valid = never_valid || !value.isValid();
+                if (value.isValid() && value.getFloat() == (is_sum ? 0.0f : 1.0f))
+                {
+                    changed = true;
+                    continue;
+                }
+                if (is_product && value.isZero())
+                {
+                    zero = true;
+                }
+            }
+            else if (is_mergeable(term.node))
+            {
+                const bool nested_sum =
+                    object_cast<SumNode>(&from) || object_cast<SubtractionNode>(&from);
+                const bool negate = object_cast<NegateNode>(&from) != nullptr;
+                if (is_sum && (nested_sum || negate))
+                {
+                    push_inputs(term.node, term.negated != negate, stack);
+                    merged.push_back(term.node);
+                    changed = true;
+                    continue;
+                }
+                if (is_product && object_cast<MultiplicationNode>(&from))
+                {
+                    push_inputs(term.node, false, stack);
+                    merged.push_back(term.node);
+                    changed = true;
+                    continue;
+                }
+            }
+            terms.push_back(term);
+        }
+        // x * 0 stays invalid while x is
+        zero = zero && std::all_of(terms.begin(), terms.end(), [&](const Term &term) {
+            return always_valid.count(term.node) > 0;
+        });
+        if (never_valid || !(changed || zero))
+        {
+            continue;
+        }
+
+        const bool any_negated = std::any_of(
+            terms.begin(), terms.end(), [](const Term &term) { return term.negated; });
+        if (zero || terms.empty())
+        {
+            const float value = zero ? 0.0f : (is_sum ? 0.0f : 1.0f);
+            const int constant =
+                add(create_replacement<ConstantNode>(graph, id, {}, Signal{value}));
+            // the other factors may be unused now, that is up to eliminateDeadNodes()
+            replace(id, constant, 0, merged);
+        }
+        else if (terms.size() == 1 && !terms[0].negated)
+        {
+            replace(id, terms[0].node, terms[0].output, merged);
+        }
+        else if (!any_negated)
+        {
+            const int wide = is_sum
+                ? create_replacement<SumNode>(graph, id, terms, terms.size())
+                : create_replacement<MultiplicationNode>(graph, id, terms, terms.size());
+            replace(id, add(wide), 0, merged);
+        }
+        else
+        {
+            std::vector<bool> subtracted;
+            for (const Term &term : terms)
+            {
+                subtracted.push_back(term.negated);
+            }
+            replace(id,
+                add(create_replacement<SubtractionNode>(graph, id, terms, std::move(subtracted))),
+                0, merged);
+        }
+    }
+    return report;
+}
+
+OptimizationReport eliminateDeadNodes(Graph &graph, const std::vector<int> &keep)
+{
+    OptimizationReport report;
+
+    const std::vector<int> ids = graph.getNodesIds();
+    std::unordered_set<int> live(keep.begin(), keep.end());
+    std::vector<int> stack(keep.begin(), keep.end());
+    for (const int id : ids)
+    {
+        if (graph.getNode(id).getNumOutputs() == 0 && live.insert(id).second)
+        {
+            stack.push_back(id);
+        }
+    }
+
+    while (!stack.empty())
+    {
+        const int id = stack.back();
+        stack.pop_back();
+        for (int input = 0, count = graph.getNode(id).getNumInputs(); input < count; ++input)
+        {
+            const int from = graph.getInputConnection(id, input).from;
+            if (from != -1 && live.insert(from).second)
+            {
+                stack.push_back(from);
+            }
+        }
+    }
+
+    for (const int id : ids)
+    {
+        if (!live.count(id))
+        {
+            graph.removeNode(id);
+            report.dead_nodes.push_back(id);
+        }
+    }
+    return report;
+}
+
+OptimizationReport optimizeGraph(Graph &graph, const std::vector<int> &keep)
+{
+    OptimizationReport report = foldConstants(graph, keep);
+
+    const OptimizationReport simplified = simplifyArithmetic(graph, keep);
+    report.rewritten_nodes = simplified.rewritten_nodes;
+    report.added_nodes.insert(
+        report.added_nodes.end(), simplified.added_nodes.begin(), simplified.added_nodes.end());
+
+    report.dead_nodes = eliminateDeadNodes(graph, keep).dead_nodes;
+    report.added_nodes.erase(std::remove_if(report.added_nodes.begin(), report.added_nodes.end(),
+                                 [&graph](int id) { return !graph.hasNode(id); }),
+        report.added_nodes.end());
+
+    // after removing dead gates, which would only count as shared logic
+    const OptimizationReport strashed = strashBooleanLogic(graph, keep);
+    report.rewritten_nodes.insert(report.rewritten_nodes.end(), strashed.rewritten_nodes.begin(),
+        strashed.rewritten_nodes.end());
+    report.added_nodes.insert(
+        report.added_nodes.end(), strashed.added_nodes.begin(), strashed.added_nodes.end());
+    return report;
+}
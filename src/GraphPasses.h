@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <vector>
+
+// Structural optimizations of a graph, to run before simulating it. Node ids stay valid except
+// for the removed nodes.
+
+struct OptimizationReport
+{
+    // ids of removed nodes
+    std::vector<int> folded_nodes;
+    std::vector<int> rewritten_nodes;
+    std::vector<int> dead_nodes;
+    // ids of the nodes that replaced folded and rewritten nodes
+    std::vector<int> added_nodes;
+};
+
+// Calculates the built-in logic and arithmetic nodes whose inputs are all constant once, and
+// replaces them by ConstantNodes. Nodes whose result is invalid stay: an uncalculated node
+// doesn't push its outputs, which a constant can't imitate. Nodes in keep are never replaced.
+OptimizationReport foldConstants(Graph &graph, const std::vector<int> &keep = {});
+
+// Rebuilds the boolean logic (AndNode, OrNode, XorNode, NotNode) as a structurally hashed
+// AndInverterGraph, which merges duplicated subexpressions, and maps it back to gates. OR, XOR and
+// wide AND/OR gates are recognized again. The graph is only changed when that needs fewer gates.
+// Gates whose output leaves the logic keep their names but not their ids; nodes in keep aren't
+// rewritten.
+OptimizationReport strashBooleanLogic(Graph &graph, const std::vector<int> &keep = {});
+
+// Rewrites float arithmetic: double NegateNodes and ReciprocalNodes cancel, nested sums and
+// products used only once merge into one wide node, constant 0 terms and constant 1 factors are
+// dropped, a product with a constant 0 factor becomes a constant, and negated terms of a sum turn
+// it into a SubtractionNode. Nodes in keep aren't rewritten or merged into others.
+//
+// The results match the original graph up to rounding: merged sums and products are associated
+// differently, 1 / (1 / x) becomes x, and the sign of a zero result may flip. A product with a
+// constant 0 factor is only replaced when all its factors are valid every tick, it is then 0 also
+// where another factor is infinite or NaN.
+OptimizationReport simplifyArithmetic(Graph &graph, const std::vector<int> &keep = {});
+
+// Removes the nodes that can't reach a sink, a node without outputs like MemoryNode. keep lists
+// nodes that are observed some other way, e.g. by a SignalProbe.
+OptimizationReport eliminateDeadNodes(Graph &graph, const std::vector<int> &keep = {});
+
+// foldConstants(), simplifyArithmetic(), eliminateDeadNodes(), then strashBooleanLogic()
+OptimizationReport optimizeGraph(Graph &graph, const std::vector<int> &keep = {});
@@ -25,14 +25,16 @@ void GraphView::construct()
 {
     // nodes
     node_views_.clear();
-    for (const int &id : graph_.getNodesIds())
+    const std::vector<int> ids = graph_.getNodesIds();
+    for (int i = 0, count = ids.size(); i < count; ++i)
     {
+        const int id = ids[i];
         const Node &node = graph_.getNode(id);
 
         NodeView node_view{node};
         const sf::Vector2f offset = {0, 0};
         node_view.setPosition(getPosition() + offset
-            + sf::Vector2f{(float)(id % 5) * DISTANCE_X, (float)(id / 5) * DISTANCE_Y});
+            + sf::Vector2f{(float)(i % 5) * DISTANCE_X, (float)(i / 5) * DISTANCE_Y});
         node_view.setNumInputs(node.getNumInputs());
         node_view.setNumOutputs(node.getNumOutputs());
         node_views_.insert({id, node_view});
@@ -66,7 +68,20 @@ void GraphView::updateIOStates()
     {
         it.second.updateIOStates();
     }
+    update_connection_colors();
+}
+
+void GraphView::updateIOStates(const SignalSnapshot &snapshot)
+{
+    for (auto &it : node_views_)
+    {
+        it.second.updateIOStates(snapshot, it.first);
+    }
+    update_connection_colors();
+}
 
+void GraphView::update_connection_colors()
+{
     for (ConnectionWithView &con_with_view : connection_views)
     {
         const int from = con_with_view.connection.from;
@@ -6,6 +6,9 @@
 
 #include <SFML/Graphics/Drawable.hpp>
 #include <SFML/Graphics/Transformable.hpp>
+#include <unordered_map>
+
+class SignalSnapshot;
 
 namespace View
 {
@@ -18,11 +21,16 @@ public:
     explicit GraphView(const Graph &graph);
     void construct();
     void updateIOStates();
+    // doesn't touch the nodes, so the graph may be running on another thread meanwhile
+    void updateIOStates(const SignalSnapshot &snapshot);
 
 protected:
     void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
     void draw_connections(sf::RenderTarget &target, sf::RenderStates states) const;
 
+private:
+    void update_connection_colors();
+
 private:
     sf::Transform transform_{sf::Transform::Identity};
     const Graph &graph_{};
@@ -0,0 +1,404 @@
+#include "InstructionTape.h"
+
+#include "Nodes.h"
+
+#include <cassert>
+#include <unordered_set>
+
+namespace
+{
+constexpr int WORD_BITS = 64;
+} // namespace
+
+InstructionTape::InstructionTape(Graph &graph)
+{
+    const auto get_op_code = [](const Node &node, OpCode &code) {
+        if (object_cast<AndNode>(&node))
+        {
+            code = OpCode::And;
+        }
+        else if (object_cast<OrNode>(&node))
+        {
+            code = OpCode::Or;
+        }
+        else if (object_cast<XorNode>(&node))
+        {
+            code = OpCode::Xor;
+        }
+        else if (object_cast<NotNode>(&node))
+        {
+            code = OpCode::Not;
+        }
+        else if (object_cast<NegateNode>(&node))
+        {
+            code = OpCode::Negate;
+        }
+        else if (object_cast<ReciprocalNode>(&node))
+        {
+            code = OpCode::Reciprocal;
+        }
+        else if (object_cast<SumNode>(&node))
+        {
+            code = OpCode::Sum;
+        }
+        else if (object_cast<MultiplicationNode>(&node))
+        {
+            code = OpCode::Multiplication;
+        }
+        else if (node.isRegister())
+        {
+            code = OpCode::Register;
+        }
+        else
+        {
+            code = OpCode::Node;
+        }
+    };
+
+    // replaces a gate by its bit plane variant
+    const auto get_bool_op_code = [](OpCode &code) {
+        switch (code)
+        {
+        case OpCode::And: code = OpCode::BoolAnd; return true;
+        case OpCode::Or: code = OpCode::BoolOr; return true;
+        case OpCode::Xor: code = OpCode::BoolXor; return true;
+        case OpCode::Not: code = OpCode::BoolNot; return true;
+        default: return false;
+        }
+    };
+
+    const std::vector<int> order = graph.getEvaluationOrder();
+    const int num_sorted = order.size() - graph.getNumNodesOnCycles();
+    const std::unordered_set<int> on_cycles(order.begin() + num_sorted, order.end());
+
+    slots_.resize(1);
+    int num_bool_slots = 1;
+    for (const int id : order)
+    {
+        const Node &node = graph.getNode(id);
+        node_outputs_[id] = output_slots_.size();
+        for (int i = 0, count = node.getNumOutputs(); i < count; ++i)
+        {
+            if (node.getOutputKind(i) == SignalKind::Bool)
+            {
+                output_slots_.push_back(-1 - num_bool_slots++);
+            }
+            else
+            {
+                output_slots_.push_back(slots_.size());
+                slots_.emplace_back();
+            }
+        }
+    }
+    // constants and registers are calculated every tick
+    calculated_.assign(output_slots_.size(), true);
+    const int num_words = (num_bool_slots + WORD_BITS - 1) / WORD_BITS;
+    bool_values_.assign(num_words, 0);
+    bool_valid_.assign(num_words, 0);
+
+    for (const int id : order)
+    {
+        const Node &node = graph.getNode(id);
+        if (object_cast<ConstantNode>(&node) || node.isRegister())
+        {
+            for (int i = 0, count = node.getNumOutputs(); i < count; ++i)
+            {
+                write_slot(output_slots_[node_outputs_[id] + i], node.getOutput(i));
+            }
+        }
+    }
+
+    for (const int id : order)
+    {
+        Node &node = graph.getNode(id);
+        if (object_cast<ConstantNode>(&node))
+        {
+            continue;
+        }
+
+        Instruction instruction;
+        get_op_code(node, instruction.code);
+        const bool calls_node = instruction.code == OpCode::Node
+            || instruction.code == OpCode::Register;
+        if (!calls_node && on_cycles.count(id))
+        {
+            // can never be calculated, its slot stays invalid
+            continue;
+        }
+
+        instruction.first_output = node_outputs_[id];
+        instruction.output = node.getNumOutputs() > 0 ? output_slots_[instruction.first_output] : 0;
+        instruction.first_input = instruction_inputs_.size();
+        instruction.num_inputs = node.getNumInputs();
+        if (calls_node)
+        {
+            instruction.node = &node;
+        }
+        if (instruction.code == OpCode::Register)
+        {
+            registers_.push_back(instructions_.size());
+        }
+
+        bool bool_inputs = true;
+        for (int input = 0; input < instruction.num_inputs; ++input)
+        {
+            const Graph::Connection connection = graph.getInputConnection(id, input);
+            int slot = 0;
+            int driver = -1;
+            if (connection.from != -1 && !on_cycles.count(connection.from))
+            {
+                slot = output_slots_[node_outputs_[connection.from] + connection.output];
+                assert(is_bool_slot(slot) == (connection.kind == SignalKind::Bool));
+
+                const Node &from_node = graph.getNode(connection.from);
+                OpCode from_code;
+                get_op_code(from_node, from_code);
+                if (object_cast<ConstantNode>(&from_node) || from_code == OpCode::Node
+                    || from_code == OpCode::Register)
+                {
+                    driver = node_outputs_[connection.from];
+                }
+            }
+            input_drivers_.push_back(driver);
+            bool_inputs = bool_inputs && (slot == 0 || connection.kind == SignalKind::Bool);
+            instruction_inputs_.push_back(slot);
+        }
+
+        // gates fed by bool outputs only work on the bit planes, unconnected inputs included
+        if (bool_inputs && get_bool_op_code(instruction.code))
+        {
+            for (int input = 0; input < instruction.num_inputs; ++input)
+            {
+                int &slot = instruction_inputs_[instruction.first_input + input];
+                slot = slot == 0 ? -1 : slot;
+            }
+        }
+
+        instructions_.push_back(instruction);
+    }
+}
+
+void InstructionTape::iterate()
+{
+    const int *all_inputs = instruction_inputs_.data();
+
+    for (const Instruction &instruction : instructions_)
+    {
+        const int *inputs = all_inputs + instruction.first_input;
+        const int num_inputs = instruction.num_inputs;
+
+        switch (instruction.code)
+        {
+        case OpCode::BoolAnd:
+        case OpCode::BoolOr:
+        case OpCode::BoolXor:
+        case OpCode::BoolNot:
+        {
+            bool valid = true;
+            bool all = true;
+            bool any = false;
+            bool parity = false;
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                const bool value = get_bit(bool_values_, inputs[i]);
+                valid = valid && get_bit(bool_valid_, inputs[i]);
+                all = all && value;
+                any = any || value;
+                parity ^= value;
+            }
+            bool value = parity;
+            if (instruction.code == OpCode::BoolAnd)
+            {
+                value = all;
+            }
+            else if (instruction.code == OpCode::BoolOr)
+            {
+                value = any;
+            }
+            else if (instruction.code == OpCode::BoolNot)
+            {
+                value = !parity;
+            }
+            write_bool_slot(instruction.output, valid, value);
+            continue;
+        }
+
+        case OpCode::Register:
+            // its slot holds the latched state, inputs are set right before the next latch
+            instruction.node->beforeCalculate();
+            continue;
+
+        case OpCode::Node:
+        {
+            Node &node = *instruction.node;
+            node.beforeCalculate();
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                const Signal signal = read_slot(inputs[i]);
+                if (is_pushed(instruction.first_input + i, signal))
+                {
+                    node.setInput(i, signal);
+                }
+            }
+
+            const bool calculated = node.canBeCalculated();
+            if (calculated)
+            {
+                node.calculate();
+            }
+            if (node.getNumOutputs() > 0)
+            {
+                calculated_[instruction.first_output] = calculated;
+            }
+            for (int i = 0, count = node.getNumOutputs(); i < count; ++i)
+            {
+                write_slot(output_slots_[instruction.first_output + i],
+                    calculated ? node.getOutput(i) : Signal::INVALID());
+            }
+            continue;
+        }
+
+        default: break;
+        }
+
+        bool all_valid = true;
+        for (int i = 0; i < num_inputs; ++i)
+        {
+            all_valid = all_valid && read_slot(inputs[i]).isValid();
+        }
+        if (!all_valid)
+        {
+            write_slot(instruction.output, Signal::INVALID());
+            continue;
+        }
+
+        Signal output;
+        switch (instruction.code)
+        {
+        case OpCode::And:
+        {
+            bool value = true;
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                value = value && read_slot(inputs[i]).getBool();
+            }
+            output = Signal(value);
+            break;
+        }
+        case OpCode::Or:
+        {
+            bool value = false;
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                value = value || read_slot(inputs[i]).getBool();
+            }
+            output = Signal(value);
+            break;
+        }
+        case OpCode::Xor:
+        {
+            bool value = false;
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                value ^= read_slot(inputs[i]).getBool();
+            }
+            output = Signal(value);
+            break;
+        }
+        case OpCode::Not: output = Signal(!read_slot(inputs[0]).getBool()); break;
+        case OpCode::Negate: output = Signal(-read_slot(inputs[0]).getFloat()); break;
+        case OpCode::Reciprocal: output = Signal(1.f / read_slot(inputs[0]).getFloat()); break;
+        case OpCode::Sum:
+        {
+            float sum = 0.0f;
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                sum += read_slot(inputs[i]).getFloat();
+            }
+            output = Signal(sum);
+            break;
+        }
+        case OpCode::Multiplication:
+        {
+            float product = 1.0f;
+            for (int i = 0; i < num_inputs; ++i)
+            {
+                product *= read_slot(inputs[i]).getFloat();
+            }
+            output = Signal(product);
+            break;
+        }
+        default: assert(false); break;
+        }
+        write_slot(instruction.output, output);
+    }
+
+    for (const int index : registers_)
+    {
+        const Instruction &instruction = instructions_[index];
+        const int *inputs = all_inputs + instruction.first_input;
+        for (int i = 0; i < instruction.num_inputs; ++i)
+        {
+            const Signal signal = read_slot(inputs[i]);
+            if (is_pushed(instruction.first_input + i, signal))
+            {
+                instruction.node->setInput(i, signal);
+            }
+        }
+    }
+    for (const int index : registers_)
+    {
+        const Instruction &instruction = instructions_[index];
+        instruction.node->latch();
+        write_slot(instruction.output, instruction.node->getOutput(0));
+    }
+}
+
+Signal InstructionTape::getOutput(int node, int output) const
+{
+    const auto it = node_outputs_.find(node);
+    assert(it != node_outputs_.end());
+    return read_slot(output_slots_[it->second + output]);
+}
+
+Signal InstructionTape::read_slot(int slot) const
+{
+    if (!is_bool_slot(slot))
+    {
+        return slots_[slot];
+    }
+    return get_bit(bool_valid_, slot) ? Signal{get_bit(bool_values_, slot)} : Signal::INVALID();
+}
+
+void InstructionTape::write_slot(int slot, Signal signal)
+{
+    if (!is_bool_slot(slot))
+    {
+        slots_[slot] = signal;
+        return;
+    }
+    write_bool_slot(slot, signal.isValid(), signal.isValid() && signal.getBool());
+}
+
+bool InstructionTape::is_pushed(int input, Signal signal) const
+{
+    // built-in opcodes output an invalid signal exactly when they weren't calculated
+    const int driver = input_drivers_[input];
+    return signal.isValid() || (driver != -1 && calculated_[driver]);
+}
+
+bool InstructionTape::get_bit(const std::vector<std::uint64_t> &plane, int slot) const
+{
+    const int index = -1 - slot;
+    return (plane[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+void InstructionTape::write_bool_slot(int slot, bool valid, bool value)
+{
+    const int index = -1 - slot;
+    const std::uint64_t mask = std::uint64_t{1} << (index % WORD_BITS);
+    std::uint64_t &valid_word = bool_valid_[index / WORD_BITS];
+    std::uint64_t &value_word = bool_values_[index / WORD_BITS];
+    valid_word = valid ? valid_word | mask : valid_word & ~mask;
+    value_word = value ? value_word | mask : value_word & ~mask;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// A graph compiled into a linear list of instructions over signal slots, one slot per node output.
+// Built-in nodes become opcodes that the interpreter loop executes directly; any other node type
+// runs through a Node opcode that calls the virtual interface.
+//
+// Outputs of SignalKind::Bool are packed into two bit planes, values and validity, the others are
+// stored as Signal. Gates driven only by bool outputs get opcodes that work on the bits.
+//
+// Produces the same outputs as Graph::iterate(), but built-in nodes only live in the slots:
+// their own getInput()/getOutput() are not updated. Constants are read when the tape is built.
+// Registers are latched at the end of iterate(), like Graph::run() does after every tick.
+class InstructionTape
+{
+public:
+    explicit InstructionTape(Graph &graph);
+
+    void iterate();
+
+    Signal getOutput(int node, int output = 0) const;
+
+    int getNumInstructions() const { return instructions_.size(); }
+
+private:
+    enum class OpCode
+    {
+        BoolAnd,
+        BoolOr,
+        BoolXor,
+        BoolNot,
+        And,
+        Or,
+        Xor,
+        Not,
+        Negate,
+        Reciprocal,
+        Sum,
+        Multiplication,
+        Node,
+        Register,
+    };
+
+    struct Instruction
+    {
+        OpCode code{OpCode::Node};
+        int output{0};       // slot of output 0
+        int first_output{0}; // index into output_slots_
+        int first_input{0};
+        int num_inputs{0};
+        Node *node{nullptr}; // only for OpCode::Node and OpCode::Register
+    };
+
+    // slots >= 0 index slots_, bool slot b is stored as -1 - b
+    static bool is_bool_slot(int slot) { return slot < 0; }
+    Signal read_slot(int slot) const;
+    void write_slot(int slot, Signal signal);
+    bool get_bit(const std::vector<std::uint64_t> &plane, int slot) const;
+    void write_bool_slot(int slot, bool valid, bool value);
+    // whether Graph would push signal into the node reading instruction input input: drivers
+    // that were calculated push even invalid outputs
+    bool is_pushed(int input, Signal signal) const;
+
+private:
+    // slot 0 and bool slot 0 stand for unconnected inputs and stay invalid
+    std::vector<Signal> slots_;
+    std::vector<std::uint64_t> bool_values_;
+    std::vector<std::uint64_t> bool_valid_;
+
+    std::vector<Instruction> instructions_;
+    std::vector<int> instruction_inputs_; // slots
+    // per instruction input, index into calculated_ for drivers that may be calculated with an
+    // invalid output (constants, registers and nodes behind OpCode::Node), -1 for the others
+    std::vector<int> input_drivers_;
+    std::vector<char> calculated_; // indexed like output_slots_, only set for such drivers
+    std::vector<int> registers_;          // indices into instructions_
+
+    std::vector<int> output_slots_;
+    // index into output_slots_ of the first output of every node
+    std::unordered_map<int, int> node_outputs_;
+};
@@ -0,0 +1,232 @@
+#include "LaneSimulator.h"
+
+#include "Nodes.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+constexpr int LANE_ALIGNMENT = 16;
+} // namespace
+
+LaneSimulator::LaneSimulator(Graph &graph, int num_lanes)
+    : num_lanes_(num_lanes)
+    , stride_((num_lanes + LANE_ALIGNMENT - 1) / LANE_ALIGNMENT * LANE_ALIGNMENT)
+{
+    assert(num_lanes >= 1);
+    values_.assign(stride_, 0.0f);
+    valid_.assign(1, false);
+
+    const auto get_op_code = [](const Node &node, OpCode &code) {
+        if (object_cast<SumNode>(&node))
+        {
+            code = OpCode::Sum;
+        }
+        else if (object_cast<MultiplicationNode>(&node))
+        {
+            code = OpCode::Multiplication;
+        }
+        else if (object_cast<NegateNode>(&node))
+        {
+            code = OpCode::Negate;
+        }
+        else if (object_cast<ReciprocalNode>(&node))
+        {
+            code = OpCode::Reciprocal;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    };
+
+    const std::vector<int> order = graph.getEvaluationOrder();
+    const int num_sorted = order.size() - graph.getNumNodesOnCycles();
+
+    for (int i = 0, count = order.size(); i < count; ++i)
+    {
+        const int id = order[i];
+        const Node &node = graph.getNode(id);
+
+        OpCode code;
+        if (!get_op_code(node, code))
+        {
+            continue;
+        }
+        const int output = add_slot(id);
+        if (i >= num_sorted)
+        {
+            continue;
+        }
+
+        Op op;
+        op.code = code;
+        op.output = output;
+        op.first_input = op_inputs_.size();
+        op.num_inputs = node.getNumInputs();
+
+        for (int input = 0; input < op.num_inputs; ++input)
+        {
+            const int from = graph.getInputConnection(id, input).from;
+            int slot = 0;
+            if (from != -1)
+            {
+                const auto it = node_slots_.find(from);
+                if (it != node_slots_.end())
+                {
+                    slot = it->second;
+                }
+                else
+                {
+                    Node &from_node = graph.getNode(from);
+                    slot = add_slot(from);
+                    input_nodes_.push_back(from);
+                    if (object_cast<ConstantNode>(&from_node))
+                    {
+                        broadcast(slot, from_node.getOutput(0));
+                    }
+                    else if (from_node.getNumInputs() == 0)
+                    {
+                        sources_.push_back({&from_node, slot});
+                    }
+                }
+            }
+            op_inputs_.push_back(slot);
+        }
+
+        ops_.push_back(op);
+    }
+}
+
+void LaneSimulator::setLanes(int node, const float *values)
+{
+    const int slot = get_slot(node);
+    std::copy(values, values + num_lanes_, &values_[slot * stride_]);
+    valid_[slot] = true;
+
+    sources_.erase(std::remove_if(sources_.begin(), sources_.end(),
+                       [slot](const Source &source) { return source.slot == slot; }),
+        sources_.end());
+}
+
+void LaneSimulator::iterate()
+{
+    for (const Source &source : sources_)
+    {
+        source.node->beforeCalculate();
+        if (source.node->canBeCalculated())
+        {
+            source.node->calculate();
+        }
+        broadcast(source.slot, source.node->getOutput(0));
+    }
+
+    const int stride = stride_;
+    for (const Op &op : ops_)
+    {
+        float *out = &values_[op.output * stride];
+        const int *inputs = &op_inputs_[op.first_input];
+
+        bool valid = true;
+        for (int i = 0; i < op.num_inputs; ++i)
+        {
+            valid = valid && valid_[inputs[i]];
+        }
+        valid_[op.output] = valid;
+        if (!valid)
+        {
+            continue;
+        }
+
+        switch (op.code)
+        {
+        case OpCode::Sum:
+            std::fill(out, out + stride, 0.0f);
+            for (int i = 0; i < op.num_inputs; ++i)
+            {
+                const float *in = &values_[inputs[i] * stride];
+                for (int lane = 0; lane < stride; ++lane)
+                {
+                    out[lane] += in[lane];
+                }
+            }
+            break;
+        case OpCode::Multiplication:
+            std::fill(out, out + stride, 1.0f);
+            for (int i = 0; i < op.num_inputs; ++i)
+            {
+                const float *in = &values_[inputs[i] * stride];
+                for (int lane = 0; lane < stride; ++lane)
+                {
+                    out[lane] *= in[lane];
+                }
+            }
+            break;
+        case OpCode::Negate:
+        {
+            const float *in = &values_[inputs[0] * stride];
+            for (int lane = 0; lane < stride; ++lane)
+            {
+                out[lane] = -in[lane];
+            }
+            break;
+        }
+        case OpCode::Reciprocal:
+        {
+            const float *in = &values_[inputs[0] * stride];
+            for (int lane = 0; lane < stride; ++lane)
+            {
+                out[lane] = 1.f / in[lane];
+            }
+            break;
+        }
+        }
+    }
+}
+
+bool LaneSimulator::isValid(int node) const
+{
+    return valid_[get_slot(node)];
+}
+
+const float *LaneSimulator::getLanes(int node) const
+{
+    return &values_[get_slot(node) * stride_];
+}
+
+Signal LaneSimulator::getSignal(int node, int lane) const
+{
+    assert(lane >= 0 && lane < num_lanes_);
+    if (!isValid(node))
+    {
+        return Signal::INVALID();
+    }
+    return Signal{getLanes(node)[lane]};
+}
+
+int LaneSimulator::get_slot(int node) const
+{
+    const auto it = node_slots_.find(node);
+    assert(it != node_slots_.end());
+    return it->second;
+}
+
+int LaneSimulator::add_slot(int node)
+{
+    const int slot = valid_.size();
+    values_.resize(values_.size() + stride_, 0.0f);
+    valid_.push_back(false);
+    node_slots_[node] = slot;
+    return slot;
+}
+
+void LaneSimulator::broadcast(int slot, Signal signal)
+{
+    valid_[slot] = signal.isValid();
+    if (signal.isValid())
+    {
+        std::fill(&values_[slot * stride_], &values_[(slot + 1) * stride_], signal.getFloat());
+    }
+}
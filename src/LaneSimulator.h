@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Runs the float part of a graph (SumNode, MultiplicationNode, NegateNode, ReciprocalNode) over
+// many independent instances at once. Every node output holds one float per lane, the graph is
+// walked once per tick and each node runs a loop over all lanes.
+//
+// Nodes that drive a kernel without being one become inputs. Constants and sources without inputs
+// (e.g. TriangleSignalNode) are broadcast to all lanes: sources are stepped on the graph itself
+// every tick. setLanes() replaces that with per-lane values, e.g. a parameter set per lane.
+// Validity is tracked per node, not per lane.
+class LaneSimulator
+{
+public:
+    LaneSimulator(Graph &graph, int num_lanes);
+
+    int getNumLanes() const { return num_lanes_; }
+
+    const std::vector<int> &getInputNodes() const { return input_nodes_; }
+    bool hasNode(int node) const { return node_slots_.find(node) != node_slots_.end(); }
+
+    // values has getNumLanes() elements
+    void setLanes(int node, const float *values);
+
+    void iterate();
+
+    bool isValid(int node) const;
+    // getNumLanes() values
+    const float *getLanes(int node) const;
+    Signal getSignal(int node, int lane) const;
+
+private:
+    enum class OpCode
+    {
+        Sum,
+        Multiplication,
+        Negate,
+        Reciprocal,
+    };
+
+    struct Op
+    {
+        OpCode code{OpCode::Sum};
+        int output{0};
+        int first_input{0};
+        int num_inputs{0};
+    };
+
+    struct Source
+    {
+        Node *node{nullptr};
+        int slot{0};
+    };
+
+    int get_slot(int node) const;
+    int add_slot(int node);
+    void broadcast(int slot, Signal signal);
+
+private:
+    int num_lanes_{0};
+    // lanes of a slot are padded to a multiple of the widest SIMD register
+    int stride_{0};
+
+    // slot 0 stands for unconnected inputs and stays invalid
+    std::vector<float> values_;
+    std::vector<char> valid_;
+
+    std::vector<Op> ops_;
+    std::vector<int> op_inputs_; // slots
+    std::vector<Source> sources_;
+    std::vector<int> input_nodes_;
+    std::unordered_map<int, int> node_slots_;
+};
@@ -0,0 +1,133 @@
+#include "NativeCircuit.h"
+
+#include "CodeGenerator.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+    #include <dlfcn.h>
+    #include <unistd.h>
+#endif
+
+NativeCircuit::~NativeCircuit()
+{
+    unload();
+}
+
+bool NativeCircuit::load(Graph &graph)
+{
+    unload();
+    error_.clear();
+
+#ifdef _WIN32
+    error_ = "native circuits are not supported on this platform";
+    return false;
+#else
+    const CodeGenerator generator(graph);
+    if (!generator.isSupported())
+    {
+        error_ = generator.getError();
+        return false;
+    }
+
+    // a fresh directory only we can access, so nobody can plant or swap the files built in it
+    std::string directory =
+        (std::filesystem::temp_directory_path() / "circuit_XXXXXX").string();
+    if (!mkdtemp(directory.data()))
+    {
+        error_ = "can't create a directory in " + std::filesystem::temp_directory_path().string();
+        return false;
+    }
+    const std::filesystem::path base = std::filesystem::path(directory) / "circuit";
+    const std::string source_path = base.string() + ".cpp";
+    const std::string library_path = base.string() + ".so";
+    const std::string log_path = base.string() + ".log";
+
+    {
+        std::ofstream source(source_path);
+        source << generator.getSource();
+        if (!source)
+        {
+            error_ = "can't write " + source_path;
+            std::error_code ignored;
+            std::filesystem::remove_all(directory, ignored);
+            return false;
+        }
+    }
+
+    const std::string command = compiler_ + " -O2 -shared -fPIC -o \"" + library_path + "\" \""
+        + source_path + "\" > \"" + log_path + "\" 2>&1";
+    const int status = std::system(command.c_str());
+
+    std::error_code ignored;
+    if (status != 0)
+    {
+        std::ifstream log(log_path);
+        std::stringstream log_text;
+        log_text << log.rdbuf();
+        error_ = "compilation failed: " + log_text.str();
+    }
+    else
+    {
+        library_ = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!library_)
+        {
+            error_ = dlerror();
+        }
+        else
+        {
+            step_ = reinterpret_cast<StepFunction>(
+                dlsym(library_, CodeGenerator::STEP_FUNCTION_NAME));
+            if (!step_)
+            {
+                error_ = dlerror();
+                unload();
+            }
+        }
+    }
+
+    // a loaded library stays mapped after its file is gone
+    std::filesystem::remove_all(directory, ignored);
+
+    if (!step_)
+    {
+        return false;
+    }
+
+    node_slots_ = generator.getSlots();
+    values_.assign(generator.getNumSlots(), 0.0f);
+    valid_.assign(generator.getNumSlots(), 0);
+    state_ = generator.getInitialState();
+    return true;
+#endif
+}
+
+void NativeCircuit::step(long long num_ticks)
+{
+    assert(isLoaded());
+    step_(values_.data(), valid_.data(), state_.data(), num_ticks);
+}
+
+Signal NativeCircuit::getOutput(int node, int output) const
+{
+    const auto it = node_slots_.find(node);
+    assert(it != node_slots_.end());
+    const int slot = it->second + output;
+    return valid_[slot] ? Signal{values_[slot]} : Signal::INVALID();
+}
+
+void NativeCircuit::unload()
+{
+#ifndef _WIN32
+    if (library_)
+    {
+        dlclose(library_);
+    }
+#endif
+    library_ = nullptr;
+    step_ = nullptr;
+}
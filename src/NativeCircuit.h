@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Builds the code of CodeGenerator into a shared library with the system compiler, loads it and
+// steps it from the host. Only available where dlopen() is.
+class NativeCircuit
+{
+public:
+    NativeCircuit() = default;
+    ~NativeCircuit();
+
+    NativeCircuit(const NativeCircuit &) = delete;
+    NativeCircuit &operator=(const NativeCircuit &) = delete;
+
+    // compiler command, "c++" by default
+    void setCompiler(std::string compiler) { compiler_ = std::move(compiler); }
+
+    bool load(Graph &graph);
+    bool isLoaded() const { return step_ != nullptr; }
+    const std::string &getError() const { return error_; }
+
+    void step(long long num_ticks = 1);
+
+    Signal getOutput(int node, int output = 0) const;
+
+private:
+    using StepFunction = void (*)(float *, unsigned char *, float *, long long);
+
+    void unload();
+
+private:
+    std::string compiler_{"c++"};
+    std::string error_;
+
+    void *library_{nullptr};
+    StepFunction step_{nullptr};
+
+    std::unordered_map<int, int> node_slots_;
+    std::vector<float> values_;
+    std::vector<unsigned char> valid_;
+    std::vector<float> state_;
+};
@@ -4,6 +4,7 @@
 #include "Object.h"
 
 #include <cassert>
+#include <memory_resource>
 #include <string>
 
 class Node : public Object
@@ -44,9 +45,45 @@ public:
 
     virtual void reset() = 0;
 
+    // see SignalKind; a float output may still drive a bool input
+    virtual SignalKind getInputKind(int num) const { return SignalKind::Float; }
+    virtual SignalKind getOutputKind(int num) const { return SignalKind::Float; }
+
+    // A register's outputs only change in latch(), which Graph calls on all registers at once
+    // after every other node of the tick was calculated. Their outputs don't depend on the current
+    // tick, so cycles that pass through a register can be evaluated.
+    virtual bool isRegister() const { return false; }
+
+    // True if beforeCalculate() leaves the inputs alone, so an input whose driver isn't calculated
+    // keeps the signal of an earlier tick
+    virtual bool keepsInputs() const { return false; }
+    virtual void latch() {}
+
     void setName(std::string name) { name_ = std::move(name); }
     const std::string &getName() const { return name_; }
 
+    // Where nodes constructed on this thread allocate their fixed-size buffers. Graph::createNode()
+    // points it at the arena of the graph for the duration of the constructor.
+    static std::pmr::memory_resource *getBufferResource() { return buffer_resource_; }
+
+    // points getBufferResource() at a resource until the scope ends, also if a constructor throws
+    class BufferResourceScope
+    {
+    public:
+        explicit BufferResourceScope(std::pmr::memory_resource *resource)
+            : previous_(buffer_resource_)
+        {
+            buffer_resource_ = resource;
+        }
+        ~BufferResourceScope() { buffer_resource_ = previous_; }
+
+        BufferResourceScope(const BufferResourceScope &) = delete;
+        BufferResourceScope &operator=(const BufferResourceScope &) = delete;
+
+    private:
+        std::pmr::memory_resource *previous_;
+    };
+
 protected:
     virtual void do_calculate() = 0;
 
@@ -55,6 +92,9 @@ protected:
     virtual Signal do_get_output(int num) const = 0;
 
 private:
+    static inline thread_local std::pmr::memory_resource *buffer_resource_ =
+        std::pmr::new_delete_resource();
+
     std::string name_;
 };
 
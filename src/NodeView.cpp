@@ -2,6 +2,7 @@
 
 #include "Globals.h"
 #include "Node.h"
+#include "SignalSnapshot.h"
 #include "ViewCommon.h"
 
 #include "SFML/Graphics/CircleShape.hpp"
@@ -61,6 +62,18 @@ void NodeView::updateIOStates()
     }
 }
 
+void NodeView::updateIOStates(const SignalSnapshot &snapshot, int node)
+{
+    for (int i = 0, count = inputs_.size(); i < count; i++)
+    {
+        set_input_signal(i, snapshot.getInput(node, i));
+    }
+    for (int i = 0, count = outputs_.size(); i < count; i++)
+    {
+        set_output_signal(i, snapshot.getOutput(node, i));
+    }
+}
+
 void NodeView::setNumInputs(int num_inputs)
 {
     inputs_.clear();
@@ -10,6 +10,7 @@
 #include <SFML/Graphics/Drawable.hpp>
 
 class Node;
+class SignalSnapshot;
 
 namespace View
 {
@@ -21,6 +22,8 @@ public:
 
     void construct();
     void updateIOStates();
+    // reads the signals of node (this node's id) from snapshot instead of the node
+    void updateIOStates(const SignalSnapshot &snapshot, int node);
 
     void setNumInputs(int num_inputs);
     void setNumOutputs(int num_outputs);
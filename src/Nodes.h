@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Node.h"
+#include "SmallArray.h"
 
 #include <algorithm>
 #include <vector>
@@ -8,7 +9,9 @@
 class ClassicNode : public Node
 {
 public:
-    explicit ClassicNode(int num_inputs = 2) { inputs_.resize(num_inputs); }
+    explicit ClassicNode(int num_inputs = 2)
+        : inputs_(num_inputs, Signal{}, getBufferResource())
+    {}
 
     int getNumInputs() const override { return inputs_.size(); }
     int getNumOutputs() const override { return 1; }
@@ -37,17 +40,32 @@ protected:
     Signal do_get_output(int num) const override { return output_; }
 
 protected:
-    std::vector<Signal> inputs_;
+    // covers nearly every gate; wider nodes spill to the buffer resource
+    static constexpr int NUM_INLINE_INPUTS = 4;
+
+    SmallArray<Signal, NUM_INLINE_INPUTS> inputs_;
     Signal output_;
 };
 
-class AndNode final : public ClassicNode
+// base of the boolean gates
+class LogicNode : public ClassicNode
+{
+public:
+    explicit LogicNode(int num_inputs)
+        : ClassicNode(num_inputs)
+    {}
+
+    SignalKind getInputKind(int num) const override { return SignalKind::Bool; }
+    SignalKind getOutputKind(int num) const override { return SignalKind::Bool; }
+};
+
+class AndNode final : public LogicNode
 {
 public:
     DECLARE_OBJECT_TYPE(AndNode);
 
     explicit AndNode(int num_inputs = 2)
-        : ClassicNode(num_inputs)
+        : LogicNode(num_inputs)
     {}
 
 protected:
@@ -58,13 +76,13 @@ protected:
     }
 };
 
-class OrNode final : public ClassicNode
+class OrNode final : public LogicNode
 {
 public:
     DECLARE_OBJECT_TYPE(OrNode);
 
     explicit OrNode(int num_inputs = 2)
-        : ClassicNode(num_inputs)
+        : LogicNode(num_inputs)
     {}
 
 protected:
@@ -75,13 +93,13 @@ protected:
     }
 };
 
-class XorNode final : public ClassicNode
+class XorNode final : public LogicNode
 {
 public:
     DECLARE_OBJECT_TYPE(XorNode);
 
     explicit XorNode(int num_inputs = 2)
-        : ClassicNode(num_inputs)
+        : LogicNode(num_inputs)
     {}
 
 protected:
@@ -96,13 +114,13 @@ protected:
     }
 };
 
-class NotNode final : public ClassicNode
+class NotNode final : public LogicNode
 {
 public:
     DECLARE_OBJECT_TYPE(NotNode);
 
     explicit NotNode()
-        : ClassicNode(1)
+        : LogicNode(1)
     {}
 
 protected:
@@ -177,6 +195,40 @@ protected:
     }
 };
 
+// A sum where some inputs are subtracted instead, e.g. in0 - in1 by default. Adds up in input
+// order from 0 like SumNode.
+class SubtractionNode final : public ClassicNode
+{
+public:
+    DECLARE_OBJECT_TYPE(SubtractionNode);
+
+    SubtractionNode()
+        : SubtractionNode({false, true})
+    {}
+
+    explicit SubtractionNode(std::vector<bool> subtracted)
+        : ClassicNode(subtracted.size())
+        , subtracted_(std::move(subtracted))
+    {}
+
+    bool isSubtracted(int input) const { return subtracted_[input]; }
+
+protected:
+    void do_calculate() override
+    {
+        float sum = 0.0f;
+        for (int i = 0, count = inputs_.size(); i < count; ++i)
+        {
+            const float value = inputs_[i].getFloat();
+            sum = subtracted_[i] ? sum - value : sum + value;
+        }
+        output_ = Signal(sum);
+    }
+
+private:
+    std::vector<bool> subtracted_;
+};
+
 class ConstantNode final : public Node
 {
 public:
@@ -220,6 +272,12 @@ public:
 
     void setOutput(Signal signal) { output_ = signal; }
 
+    float getMin() const { return min_; }
+    float getMax() const { return max_; }
+    float getDelta() const { return delta_; }
+    float getCurrent() const { return cur_; }
+    bool isGoingUp() const { return dir_ == Direction::Up; }
+
     int getNumInputs() const override { return 0; }
     int getNumOutputs() const override { return 1; }
 
@@ -287,6 +345,7 @@ public:
     bool canBeCalculated() const override { return true; }
     void reset() override {}
     void beforeCalculate() override {}
+    bool keepsInputs() const override { return true; }
 
 protected:
     void do_set_input(int num, Signal signal) override { cur_signal_ = signal; }
@@ -298,4 +357,69 @@ protected:
 private:
     Signal cur_signal_;
     std::vector<Signal> memory_;
+};
+
+// Outputs the signal latched at the end of the previous tick, see Node::isRegister().
+class RegisterNode : public Node
+{
+public:
+    explicit RegisterNode(Signal initial)
+        : initial_(initial)
+        , state_(initial)
+    {}
+
+    int getNumInputs() const override { return 1; }
+    int getNumOutputs() const override { return 1; }
+
+    bool isRegister() const override { return true; }
+    Signal getState() const { return state_; }
+
+    bool canBeCalculated() const override { return true; }
+    void reset() override
+    {
+        input_.invalidate();
+        state_ = initial_;
+    }
+    void beforeCalculate() override { input_.invalidate(); }
+
+protected:
+    void do_set_input(int num, Signal signal) override { input_ = signal; }
+    Signal do_get_input(int num) const override { return input_; }
+    Signal do_get_output(int num) const override { return state_; }
+
+    void do_calculate() override {}
+
+protected:
+    Signal initial_;
+    Signal input_;
+    Signal state_;
+};
+
+// one tick delay of any signal
+class DelayNode final : public RegisterNode
+{
+public:
+    DECLARE_OBJECT_TYPE(DelayNode);
+
+    explicit DelayNode(Signal initial = Signal::ZERO())
+        : RegisterNode(initial)
+    {}
+
+    void latch() override { state_ = input_; }
+};
+
+// latches the input as a bool
+class DFlipFlopNode final : public RegisterNode
+{
+public:
+    DECLARE_OBJECT_TYPE(DFlipFlopNode);
+
+    explicit DFlipFlopNode(bool initial = false)
+        : RegisterNode(Signal{initial})
+    {}
+
+    SignalKind getInputKind(int num) const override { return SignalKind::Bool; }
+    SignalKind getOutputKind(int num) const override { return SignalKind::Bool; }
+
+    void latch() override { state_ = input_.isValid() ? Signal{input_.getBool()} : input_; }
 };
\ No newline at end of file
@@ -25,3 +25,13 @@ inline T *object_cast(Object *object)
     }
     return nullptr;
 }
+
+template<class T>
+inline const T *object_cast(const Object *object)
+{
+    if (object->getType() == T::getTypeStatic())
+    {
+        return static_cast<const T *>(object);
+    }
+    return nullptr;
+}
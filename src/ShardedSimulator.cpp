@@ -0,0 +1,550 @@
+#include "ShardedSimulator.h"
+
+#include "GraphPartition.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <csignal>
+    #include <sys/mman.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+#ifdef __linux__
+    #include <sys/prctl.h>
+#endif
+
+namespace
+{
+
+constexpr int CACHE_LINE_SIZE = 64;
+constexpr std::uint32_t RING_CAPACITY = 1024; // messages, a power of two
+
+// waiting spins this often before yielding, and yields this often before sleeping
+constexpr int NUM_SPINS = 2000;
+constexpr int NUM_YIELDS = 200;
+constexpr std::chrono::microseconds SLEEP_TIME{50};
+
+std::size_t align_up(std::size_t size)
+{
+    return (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+} // namespace
+
+// the atomics are shared between processes, which needs them to be lock-free
+static_assert(std::atomic<long long>::is_always_lock_free);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+struct ShardedSimulator::Control
+{
+    alignas(CACHE_LINE_SIZE) std::atomic<long long> target_tick{0};
+    std::atomic<int> quit{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<int> num_arrived{0};
+    std::atomic<long long> generation{0};
+};
+
+struct ShardedSimulator::Ring
+{
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> head{0}; // next message to read
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> tail{0}; // next message to write
+    alignas(CACHE_LINE_SIZE) Message messages[RING_CAPACITY];
+};
+
+ShardedSimulator::ShardedSimulator(Graph &graph, int num_shards)
+{
+    assert(num_shards >= 1);
+
+    const GraphPartition partition = partitionGraph(graph, num_shards);
+    const std::vector<int> order = graph.getEvaluationOrder();
+
+    shards_.resize(num_shards);
+    std::unordered_map<int, int> positions;
+    for (int position = 0, count = order.size(); position < count; ++position)
+    {
+        const int id = order[position];
+        Node &node = graph.getNode(id);
+        // nodes without outputs are what this process looks at
+        const int shard = node.getNumOutputs() == 0 ? 0 : partition.getPart(id);
+        positions[id] = position;
+        node_shards_[id] = shard;
+        node_indices_[id] = shards_[shard].nodes.size();
+
+        ShardNode shard_node;
+        shard_node.id = id;
+        shard_node.node = &node;
+        shard_node.first_output = num_outputs_;
+        num_outputs_ += node.getNumOutputs();
+        if (node.isRegister())
+        {
+            shards_[shard].registers.push_back(shards_[shard].nodes.size());
+        }
+        shards_[shard].nodes.push_back(shard_node);
+    }
+
+    // one incoming value per node output and receiving shard, however many inputs it drives there
+    ring_indices_.assign(num_shards * num_shards, -1);
+    std::unordered_map<long long, int> incoming_indices;
+    std::vector<std::vector<Send>> node_sends(order.size());
+    for (Shard &shard : shards_)
+    {
+        const int to_shard = &shard - shards_.data();
+        for (ShardNode &shard_node : shard.nodes)
+        {
+            shard_node.first_remote_input = shard.remote_inputs.size();
+            for (int input = 0, count = shard_node.node->getNumInputs(); input < count; ++input)
+            {
+                const Graph::Connection connection = graph.getInputConnection(shard_node.id, input);
+                if (connection.from == -1)
+                {
+                    continue;
+                }
+                const int from_shard = node_shards_[connection.from];
+                if (from_shard == to_shard)
+                {
+                    continue;
+                }
+
+                const ShardNode &from = shards_[from_shard].nodes[node_indices_[connection.from]];
+                const long long key =
+                    static_cast<long long>(from.first_output + connection.output) * num_shards
+                    + to_shard;
+                auto it = incoming_indices.find(key);
+                if (it == incoming_indices.end())
+                {
+                    int &ring = ring_indices_[num_shards * from_shard + to_shard];
+                    if (ring == -1)
+                    {
+                        ring = num_rings_++;
+                        shard.incoming_rings.push_back(ring);
+                    }
+                    it = incoming_indices.emplace(key, shard.num_incoming++).first;
+
+                    Send send;
+                    send.output = connection.output;
+                    send.ring = ring;
+                    send.incoming = it->second;
+                    node_sends[positions[connection.from]].push_back(send);
+                    ++num_boundary_signals_;
+                }
+
+                RemoteInput remote_input;
+                remote_input.node = shard_node.node;
+                remote_input.input = input;
+                remote_input.incoming = it->second;
+                if (positions[connection.from] < positions[shard_node.id])
+                {
+                    shard.remote_inputs.push_back(remote_input);
+                }
+                else
+                {
+                    shard.late_inputs.push_back(remote_input);
+                }
+            }
+            shard_node.num_remote_inputs =
+                shard.remote_inputs.size() - shard_node.first_remote_input;
+        }
+    }
+
+    for (Shard &shard : shards_)
+    {
+        const int from_shard = &shard - shards_.data();
+        for (ShardNode &shard_node : shard.nodes)
+        {
+            shard_node.first_connection = shard.connections.size();
+            for (const Graph::Connection &connection : graph.getOutputConnections(shard_node.id))
+            {
+                if (node_shards_[connection.to] != from_shard)
+                {
+                    continue;
+                }
+                LocalConnection local;
+                local.output = connection.output;
+                local.to = &graph.getNode(connection.to);
+                local.input = connection.input;
+                shard.connections.push_back(local);
+            }
+            shard_node.num_connections = shard.connections.size() - shard_node.first_connection;
+
+            const std::vector<Send> &sends = node_sends[positions[shard_node.id]];
+            shard_node.first_send = shard.sends.size();
+            shard_node.num_sends = sends.size();
+            shard.sends.insert(shard.sends.end(), sends.begin(), sends.end());
+        }
+    }
+}
+
+ShardedSimulator::~ShardedSimulator()
+{
+    if (running_)
+    {
+        stop();
+    }
+#ifndef _WIN32
+    if (memory_)
+    {
+        munmap(memory_, memory_size_);
+    }
+#endif
+}
+
+int ShardedSimulator::getShard(int node) const
+{
+    const auto it = node_shards_.find(node);
+    assert(it != node_shards_.end());
+    return it->second;
+}
+
+bool ShardedSimulator::start()
+{
+    assert(!running_ && !memory_);
+    error_.clear();
+
+#ifdef _WIN32
+    error_ = "sharded simulation is not supported on this platform";
+    return false;
+#else
+    const std::size_t rings_offset = align_up(sizeof(Control));
+    const std::size_t outputs_offset = rings_offset + num_rings_ * sizeof(Ring);
+    memory_size_ = outputs_offset + num_outputs_ * sizeof(Signal);
+    // anonymous shared memory stays shared with the children forked below
+    memory_ =
+        mmap(nullptr, memory_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory_ == MAP_FAILED)
+    {
+        memory_ = nullptr;
+        error_ = std::string("can't map shared memory: ") + std::strerror(errno);
+        return false;
+    }
+
+    char *bytes = static_cast<char *>(memory_);
+    control_ = new (bytes) Control;
+    rings_ = reinterpret_cast<Ring *>(bytes + rings_offset);
+    for (int ring = 0; ring < num_rings_; ++ring)
+    {
+        new (&rings_[ring]) Ring;
+    }
+    outputs_ = new (bytes + outputs_offset) Signal[num_outputs_];
+    for (const Shard &shard : shards_)
+    {
+        for (const ShardNode &shard_node : shard.nodes)
+        {
+            for (int output = 0, count = shard_node.node->getNumOutputs(); output < count; ++output)
+            {
+                outputs_[shard_node.first_output + output] = shard_node.node->getOutput(output);
+            }
+        }
+    }
+
+    // sized for any shard, the children shouldn't allocate
+    int max_incoming = 0;
+    for (const Shard &shard : shards_)
+    {
+        max_incoming = std::max(max_incoming, shard.num_incoming);
+    }
+    received_.assign(max_incoming, Message{});
+    received_ticks_.assign(max_incoming, -1);
+    num_received_ = 0;
+
+    shard_ = 0;
+    running_ = true;
+    for (int shard = 1; shard < getNumShards(); ++shard)
+    {
+        const pid_t pid = fork();
+        if (pid == -1)
+        {
+            error_ = std::string("can't fork shard ") + std::to_string(shard) + ": "
+                + std::strerror(errno);
+            stop();
+            return false;
+        }
+        if (pid == 0)
+        {
+            run_child(shard);
+        }
+        shards_[shard].pid = pid;
+    }
+    return true;
+#endif
+}
+
+bool ShardedSimulator::run(long long num_ticks)
+{
+    if (!running_)
+    {
+        return false;
+    }
+
+    control_->target_tick.store(tick_ + num_ticks);
+    for (long long tick = 0; tick < num_ticks; ++tick)
+    {
+        if (!run_tick())
+        {
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+Signal ShardedSimulator::getOutput(int node, int output) const
+{
+    const int shard = getShard(node);
+    const ShardNode &shard_node = shards_[shard].nodes[node_indices_.at(node)];
+    assert(output >= 0 && output < shard_node.node->getNumOutputs());
+    if (shard == 0 || !outputs_)
+    {
+        return shard_node.node->getOutput(output);
+    }
+    return outputs_[shard_node.first_output + output];
+}
+
+void ShardedSimulator::run_child(int shard)
+{
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    shard_ = shard;
+    while (true)
+    {
+        // returns only when there is work, quitting exits the process
+        wait_until([this]() { return control_->target_tick.load() > tick_; });
+        run_tick();
+    }
+}
+
+bool ShardedSimulator::run_tick()
+{
+    Shard &shard = shards_[shard_];
+    for (const ShardNode &shard_node : shard.nodes)
+    {
+        shard_node.node->beforeCalculate();
+    }
+
+    for (const ShardNode &shard_node : shard.nodes)
+    {
+        Node &node = *shard_node.node;
+        for (int i = 0; i < shard_node.num_remote_inputs; ++i)
+        {
+            const RemoteInput &remote_input =
+                shard.remote_inputs[shard_node.first_remote_input + i];
+            const int incoming = remote_input.incoming;
+            if (!wait_until([&]() {
+                    receive();
+                    return received_ticks_[incoming] == tick_;
+                }))
+            {
+                return false;
+            }
+            if (received_[incoming].calculated)
+            {
+                node.setInput(remote_input.input, received_[incoming].value);
+            }
+        }
+
+        const bool calculated = node.canBeCalculated();
+        if (calculated)
+        {
+            node.calculate();
+            const LocalConnection *connection = &shard.connections[shard_node.first_connection];
+            for (int i = 0; i < shard_node.num_connections; ++i, ++connection)
+            {
+                connection->to->setInput(connection->input, node.getOutput(connection->output));
+            }
+        }
+
+        for (int i = 0; i < shard_node.num_sends; ++i)
+        {
+            const Send &send_info = shard.sends[shard_node.first_send + i];
+            Message message;
+            message.incoming = send_info.incoming;
+            message.calculated = calculated;
+            if (calculated)
+            {
+                message.value = node.getOutput(send_info.output);
+            }
+            if (!send(send_info.ring, message))
+            {
+                return false;
+            }
+        }
+    }
+
+    // every incoming value arrives once per tick, and none of the next tick before the barrier
+    if (!wait_until([&]() {
+            receive();
+            return num_received_ == shard.num_incoming;
+        }))
+    {
+        return false;
+    }
+    num_received_ = 0;
+    for (const RemoteInput &late_input : shard.late_inputs)
+    {
+        if (received_[late_input.incoming].calculated)
+        {
+            late_input.node->setInput(late_input.input, received_[late_input.incoming].value);
+        }
+    }
+
+    for (const int index : shard.registers)
+    {
+        shard.nodes[index].node->latch();
+    }
+
+    ++tick_;
+    if (shard_ != 0 && tick_ == control_->target_tick.load())
+    {
+        publish_outputs();
+    }
+    return barrier();
+}
+
+bool ShardedSimulator::send(int ring_index, const Message &message)
+{
+    Ring &ring = rings_[ring_index];
+    const std::uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    // keep receiving while the ring is full, the receiver may be waiting for this shard as well
+    if (tail - ring.head.load(std::memory_order_acquire) == RING_CAPACITY
+        && !wait_until([&]() {
+               receive();
+               return tail - ring.head.load(std::memory_order_acquire) < RING_CAPACITY;
+           }))
+    {
+        return false;
+    }
+    ring.messages[tail % RING_CAPACITY] = message;
+    ring.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void ShardedSimulator::receive()
+{
+    for (const int ring_index : shards_[shard_].incoming_rings)
+    {
+        Ring &ring = rings_[ring_index];
+        std::uint32_t head = ring.head.load(std::memory_order_relaxed);
+        const std::uint32_t tail = ring.tail.load(std::memory_order_acquire);
+        if (head == tail)
+        {
+            continue;
+        }
+        for (; head != tail; ++head)
+        {
+            const Message &message = ring.messages[head % RING_CAPACITY];
+            received_[message.incoming] = message;
+            received_ticks_[message.incoming] = tick_;
+            ++num_received_;
+        }
+        ring.head.store(tail, std::memory_order_release);
+    }
+}
+
+bool ShardedSimulator::barrier()
+{
+    const long long generation = control_->generation.load();
+    if (control_->num_arrived.fetch_add(1) + 1 == getNumShards())
+    {
+        control_->num_arrived.store(0);
+        control_->generation.fetch_add(1);
+        return true;
+    }
+    return wait_until([&]() { return control_->generation.load() != generation; });
+}
+
+void ShardedSimulator::publish_outputs()
+{
+    for (const ShardNode &shard_node : shards_[shard_].nodes)
+    {
+        for (int output = 0, count = shard_node.node->getNumOutputs(); output < count; ++output)
+        {
+            outputs_[shard_node.first_output + output] = shard_node.node->getOutput(output);
+        }
+    }
+}
+
+// Returns false if the simulation stopped meanwhile; a child process exits instead.
+template<class Condition>
+bool ShardedSimulator::wait_until(Condition condition)
+{
+    for (int num_tries = 0; !condition();)
+    {
+        if (control_->quit.load())
+        {
+#ifndef _WIN32
+            if (shard_ != 0)
+            {
+                _exit(0);
+            }
+#endif
+            return false;
+        }
+
+        if (num_tries < NUM_SPINS)
+        {
+            ++num_tries;
+        }
+        else if (num_tries < NUM_SPINS + NUM_YIELDS)
+        {
+            ++num_tries;
+            std::this_thread::yield();
+        }
+        else
+        {
+            if (shard_ == 0 && !check_children())
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(SLEEP_TIME);
+        }
+    }
+    return true;
+}
+
+bool ShardedSimulator::check_children()
+{
+#ifndef _WIN32
+    for (int shard = 1; shard < getNumShards(); ++shard)
+    {
+        int status = 0;
+        if (shards_[shard].pid != -1 && waitpid(shards_[shard].pid, &status, WNOHANG) != 0)
+        {
+            shards_[shard].pid = -1;
+            error_ = "shard " + std::to_string(shard);
+            if (WIFSIGNALED(status))
+            {
+                error_ += " was killed by signal " + std::to_string(WTERMSIG(status));
+            }
+            else
+            {
+                error_ += " exited with status " + std::to_string(WEXITSTATUS(status));
+            }
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+void ShardedSimulator::stop()
+{
+    control_->quit.store(1);
+#ifndef _WIN32
+    for (Shard &shard : shards_)
+    {
+        if (shard.pid != -1)
+        {
+            waitpid(shard.pid, nullptr, 0);
+            shard.pid = -1;
+        }
+    }
+#endif
+    running_ = false;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Runs one graph as several processes on one machine. partitionGraph() splits the nodes into
+// shards: shard 0 is calculated in this process on the graph itself, every other shard in a child
+// process that start() forks, on its own copy of the graph. Signals crossing shards are sent every
+// tick through single-producer single-consumer rings in shared memory, and all shards meet at a
+// barrier after every tick.
+//
+// Every shard walks its nodes in Graph::getEvaluationOrder() and waits for the remote inputs that
+// come from earlier nodes, so the results match EvaluationMode::Scheduled. Nodes without outputs
+// stay in shard 0 where this process sees them; the outputs of the other shards are published to
+// shared memory at the end of every run().
+//
+// Shards split the work, not the memory: the whole graph is built in this process, and every
+// child starts as a fork() of it, so each one maps the full graph (copy-on-write, its pages are
+// shared until a shard writes to them). Graphs that don't fit into one process can't be run this
+// way.
+//
+// A shard process that dies stops the simulation: run() returns false and getError() says which
+// one. Only available on POSIX systems. The structure of the graph must not change meanwhile.
+class ShardedSimulator
+{
+public:
+    ShardedSimulator(Graph &graph, int num_shards);
+    ~ShardedSimulator();
+
+    ShardedSimulator(const ShardedSimulator &) = delete;
+    ShardedSimulator &operator=(const ShardedSimulator &) = delete;
+
+    int getNumShards() const { return shards_.size(); }
+    int getShard(int node) const;
+    // signals sent between shards every tick
+    int getNumBoundarySignals() const { return num_boundary_signals_; }
+
+    // forks the shard processes
+    bool start();
+    bool isRunning() const { return running_; }
+    const std::string &getError() const { return error_; }
+
+    bool iterate() { return run(1); }
+    bool run(long long num_ticks);
+    long long getTick() const { return tick_; }
+
+    Signal getOutput(int node, int output = 0) const;
+
+private:
+    struct Control;
+    struct Ring;
+
+    struct Message
+    {
+        int incoming{0};
+        // false if the node couldn't be calculated, the input then isn't set
+        int calculated{0};
+        Signal value;
+    };
+
+    struct LocalConnection
+    {
+        int output{-1};
+        Node *to{nullptr};
+        int input{-1};
+    };
+
+    struct RemoteInput
+    {
+        Node *node{nullptr};
+        int input{-1};
+        int incoming{0}; // index into the received values of the shard
+    };
+
+    struct Send
+    {
+        int output{-1};
+        int ring{-1};
+        int incoming{0}; // index at the receiving shard
+    };
+
+    struct ShardNode
+    {
+        int id{-1};
+        Node *node{nullptr};
+        int first_connection{0};
+        int num_connections{0};
+        int first_remote_input{0};
+        int num_remote_inputs{0};
+        int first_send{0};
+        int num_sends{0};
+        int first_output{0}; // index into the published outputs
+    };
+
+    struct Shard
+    {
+        std::vector<ShardNode> nodes; // in evaluation order
+        std::vector<int> registers;   // indices into nodes
+        std::vector<LocalConnection> connections;
+        // inputs driven by earlier nodes, set right before their node is calculated
+        std::vector<RemoteInput> remote_inputs;
+        // inputs driven by later nodes, set at the end of the tick like Graph does
+        std::vector<RemoteInput> late_inputs;
+        std::vector<Send> sends;
+        std::vector<int> incoming_rings;
+        int num_incoming{0};
+        int pid{-1};
+    };
+
+    [[noreturn]] void run_child(int shard);
+    bool run_tick();
+    bool send(int ring, const Message &message);
+    void receive();
+    bool barrier();
+    void publish_outputs();
+    template<class Condition>
+    bool wait_until(Condition condition);
+    bool check_children();
+    void stop();
+
+private:
+    std::vector<Shard> shards_;
+    std::unordered_map<int, int> node_shards_;
+    std::unordered_map<int, int> node_indices_; // indices into Shard::nodes
+    std::vector<int> ring_indices_;             // by num_shards * from + to, -1 if unused
+    int num_rings_{0};
+    int num_outputs_{0};
+    int num_boundary_signals_{0};
+
+    void *memory_{nullptr};
+    std::size_t memory_size_{0};
+    Control *control_{nullptr};
+    Ring *rings_{nullptr};
+    Signal *outputs_{nullptr};
+
+    // state of the shard calculated by this process
+    int shard_{0};
+    long long tick_{0};
+    std::vector<Message> received_;
+    std::vector<long long> received_ticks_;
+    int num_received_{0};
+
+    bool running_{false};
+    std::string error_;
+};
@@ -1,8 +1,21 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
+// What a node input or output carries. Bool signals are only ever 0, 1 or invalid, so engines can
+// store them as bits; a bool input only looks at whether its signal is zero.
+enum class SignalKind
+{
+    Float,
+    Bool,
+};
+
+// A float or the invalid state, in 4 bytes. Invalid is a reserved signaling NaN: arithmetic only
+// ever produces quiet NaNs, so the only way to get its bits is setValue() with exactly them, which
+// stores a quiet NaN instead.
 class Signal final
 {
 public:
@@ -15,48 +28,61 @@ public:
     explicit Signal(float value) { setValue(value); }
 
     bool notZero() const { return !isZero(); }
-    bool isZero() const { return is_valid_ && value_ == 0.0f; }
-    bool isValid() const { return is_valid_; }
+    // -0 has the sign bit set, everything else that is zero
+    bool isZero() const { return (bits_ & ~SIGN_BIT) == 0; }
+    bool isValid() const { return bits_ != INVALID_BITS; }
 
     void toZero() { setValue(0.0f); }
     void toOne() { setValue(1.0f); }
-    void invalidate() { is_valid_ = false; }
+    void invalidate() { bits_ = INVALID_BITS; }
 
-    void setValue(bool value)
-    {
-        is_valid_ = true;
-        value_ = value ? 1.0f : 0.0f;
-    }
+    void setValue(bool value) { setValue(value ? 1.0f : 0.0f); }
 
     void setValue(float value)
     {
-        is_valid_ = true;
-        value_ = value;
+        std::memcpy(&bits_, &value, sizeof(bits_));
+        if (bits_ == INVALID_BITS)
+        {
+            bits_ |= QUIET_BIT;
+        }
     }
 
-    bool getBool() const
-    {
-        assert(isValid());
-        return value_ != 0.0f;
-    }
+    bool getBool() const { return getFloat() != 0.0f; }
 
     float getFloat() const
     {
         assert(isValid());
-        return value_;
+        float value;
+        std::memcpy(&value, &bits_, sizeof(value));
+        return value;
     }
 
     bool operator==(const Signal &rhs) const
     {
-        return is_valid_ == rhs.is_valid_ && value_ == rhs.value_;
+        if (!isValid() || !rhs.isValid())
+        {
+            return isValid() == rhs.isValid();
+        }
+        return getFloat() == rhs.getFloat();
     }
     bool operator!=(const Signal &rhs) const { return !(rhs == *this); }
 
+    // unlike operator==, tells 0 from -0 and matches equal NaNs
+    bool isIdentical(const Signal &rhs) const { return bits_ == rhs.bits_; }
+
+    // the representation, e.g. to check many signals at once against INVALID_BITS
+    std::uint32_t getBits() const { return bits_; }
+    static constexpr std::uint32_t INVALID_BITS = 0x7f8dead1u;
+
 private:
-    bool is_valid_{false};
-    float value_{0.0f};
+    static constexpr std::uint32_t SIGN_BIT = 0x80000000u;
+    static constexpr std::uint32_t QUIET_BIT = 0x00400000u;
+
+    std::uint32_t bits_{INVALID_BITS};
 };
 
+static_assert(sizeof(Signal) == 4);
+
 inline std::ostream &operator<<(std::ostream &os, const Signal signal)
 {
     if (!signal.isValid())
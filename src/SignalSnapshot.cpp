@@ -0,0 +1,83 @@
+#include "SignalSnapshot.h"
+
+#include "Graph.h"
+
+#include <cassert>
+
+Signal SignalSnapshot::getInput(int node, int input) const
+{
+    const NodeSignals &signals = get_node_signals(node);
+    assert(input >= 0 && input < signals.num_inputs);
+    return inputs_[signals.first_input + input];
+}
+
+Signal SignalSnapshot::getOutput(int node, int output) const
+{
+    const NodeSignals &signals = get_node_signals(node);
+    assert(output >= 0 && output < signals.num_outputs);
+    return outputs_[signals.first_output + output];
+}
+
+const SignalSnapshot::NodeSignals &SignalSnapshot::get_node_signals(int node) const
+{
+    assert(hasNode(node));
+    return nodes_->find(node)->second;
+}
+
+// all three buffers are allocated up front, taking a snapshot doesn't allocate
+SnapshotPublisher::SnapshotPublisher(const Graph &graph)
+    : buffer_(create_snapshot(graph))
+{}
+
+SignalSnapshot SnapshotPublisher::create_snapshot(const Graph &graph)
+{
+    auto nodes = std::make_shared<std::unordered_map<int, SignalSnapshot::NodeSignals>>();
+    SignalSnapshot snapshot;
+    for (const int id : graph.getNodesIds())
+    {
+        const Node &node = graph.getNode(id);
+        SignalSnapshot::NodeSignals signals;
+        signals.first_input = snapshot.inputs_.size();
+        signals.num_inputs = node.getNumInputs();
+        signals.first_output = snapshot.outputs_.size();
+        signals.num_outputs = node.getNumOutputs();
+        (*nodes)[id] = signals;
+        nodes_.push_back(&node);
+        snapshot.inputs_.resize(snapshot.inputs_.size() + signals.num_inputs);
+        snapshot.outputs_.resize(snapshot.outputs_.size() + signals.num_outputs);
+    }
+    snapshot.nodes_ = std::move(nodes);
+
+    take(snapshot, graph.getTick() - 1);
+    return snapshot;
+}
+
+void SnapshotPublisher::onTick(const Graph &graph, long long tick)
+{
+    take(buffer_.getWriteBuffer(), tick);
+    buffer_.publish();
+}
+
+const SignalSnapshot &SnapshotPublisher::getLatest()
+{
+    buffer_.update();
+    return buffer_.getReadBuffer();
+}
+
+void SnapshotPublisher::take(SignalSnapshot &snapshot, long long tick) const
+{
+    snapshot.tick_ = tick;
+    Signal *input = snapshot.inputs_.data();
+    Signal *output = snapshot.outputs_.data();
+    for (const Node *node : nodes_)
+    {
+        for (int i = 0, count = node->getNumInputs(); i < count; ++i)
+        {
+            *input++ = node->getInput(i);
+        }
+        for (int i = 0, count = node->getNumOutputs(); i < count; ++i)
+        {
+            *output++ = node->getOutput(i);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "TickObserver.h"
+#include "TripleBuffer.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class Node;
+
+// Node inputs and outputs as they were after one tick
+class SignalSnapshot
+{
+public:
+    // the tick the signals were taken after, -1 if taken before the first one
+    long long getTick() const { return tick_; }
+
+    bool hasNode(int node) const { return nodes_ && nodes_->find(node) != nodes_->end(); }
+    Signal getInput(int node, int input) const;
+    Signal getOutput(int node, int output) const;
+
+private:
+    friend class SnapshotPublisher;
+
+    struct NodeSignals
+    {
+        int first_input{0};
+        int num_inputs{0};
+        int first_output{0};
+        int num_outputs{0};
+    };
+
+    const NodeSignals &get_node_signals(int node) const;
+
+private:
+    // shared by all snapshots of a publisher
+    std::shared_ptr<const std::unordered_map<int, NodeSignals>> nodes_;
+    long long tick_{-1};
+    std::vector<Signal> inputs_;
+    std::vector<Signal> outputs_;
+};
+
+// Takes a SignalSnapshot after every tick of the graph it observes and publishes it through a
+// TripleBuffer, so another thread, e.g. the renderer, can read the latest complete tick while the
+// graph keeps running. Taking a snapshot copies every signal but never waits for the reader.
+//
+// The snapshots cover the nodes the graph had when the publisher was created; create a new one
+// after structural changes.
+class SnapshotPublisher final : public TickObserver
+{
+public:
+    explicit SnapshotPublisher(const Graph &graph);
+
+    void onTick(const Graph &graph, long long tick) override;
+
+    // reader side, from one thread: the latest published snapshot, valid until the next call
+    const SignalSnapshot &getLatest();
+
+private:
+    // fills nodes_
+    SignalSnapshot create_snapshot(const Graph &graph);
+    void take(SignalSnapshot &snapshot, long long tick) const;
+
+private:
+    std::vector<const Node *> nodes_; // in the order their signals are stored
+    TripleBuffer<SignalSnapshot> buffer_;
+};
@@ -0,0 +1,138 @@
+#include "SimulationRunner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+SimulationRunner::SimulationRunner(Graph &graph)
+    : graph_(graph)
+    , publisher_(graph)
+    , tick_(graph.getTick())
+{
+    graph_.addObserver(&publisher_);
+    thread_ = std::thread([this]() { thread_loop(); });
+}
+
+SimulationRunner::~SimulationRunner()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    graph_.removeObserver(&publisher_);
+}
+
+void SimulationRunner::run()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            running_ = true;
+            restart_pacing_ = true;
+        }
+    }
+    cv_.notify_all();
+}
+
+void SimulationRunner::pause()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+}
+
+bool SimulationRunner::isRunning() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+void SimulationRunner::step(long long num_ticks)
+{
+    assert(num_ticks >= 0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        num_steps_ += num_ticks;
+    }
+    cv_.notify_all();
+}
+
+void SimulationRunner::setTickRate(double ticks_per_second)
+{
+    assert(ticks_per_second >= 0.0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tick_rate_ = ticks_per_second;
+        restart_pacing_ = true;
+    }
+    cv_.notify_all();
+}
+
+double SimulationRunner::getTickRate() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tick_rate_;
+}
+
+void SimulationRunner::thread_loop()
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point last_time;
+    double accumulated_ticks = 0.0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        cv_.wait(lock, [this]() { return stop_ || running_ || num_steps_ > 0; });
+        if (stop_)
+        {
+            break;
+        }
+
+        long long num_ticks = 0;
+        if (num_steps_ > 0)
+        {
+            num_ticks = std::min(num_steps_, MAX_BATCH_SIZE);
+            num_steps_ -= num_ticks;
+        }
+        else if (tick_rate_ == 0.0)
+        {
+            num_ticks = MAX_BATCH_SIZE;
+        }
+        else
+        {
+            const Clock::time_point now = Clock::now();
+            if (restart_pacing_)
+            {
+                restart_pacing_ = false;
+                last_time = now;
+                // the first tick is due right away
+                accumulated_ticks = 1.0;
+            }
+            const double elapsed_seconds = std::chrono::duration<double>(now - last_time).count();
+            accumulated_ticks += elapsed_seconds * tick_rate_;
+            accumulated_ticks =
+                std::min(accumulated_ticks, tick_rate_ * MAX_CATCH_UP_SECONDS + 1.0);
+            last_time = now;
+
+            num_ticks = std::min(static_cast<long long>(accumulated_ticks), MAX_BATCH_SIZE);
+            if (num_ticks == 0)
+            {
+                // sleep until the next tick is due or a command comes in
+                const std::chrono::duration<double> wait_time{
+                    (1.0 - accumulated_ticks) / tick_rate_};
+                cv_.wait_for(lock, wait_time);
+                continue;
+            }
+            accumulated_ticks -= num_ticks;
+        }
+
+        lock.unlock();
+        graph_.run(num_ticks);
+        tick_ = graph_.getTick();
+        lock.lock();
+    }
+}
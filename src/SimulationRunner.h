@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Graph.h"
+#include "SignalSnapshot.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Runs a graph on a background thread, decoupled from the frame rate of whoever watches it.
+// While running, ticks are paced by an accumulator: the time passed times the tick rate is added
+// up and that many ticks are run, so ticks missed to a slow batch are caught up (within
+// MAX_CATCH_UP_SECONDS). A tick rate of 0 runs as fast as possible.
+//
+// Other threads must not touch the graph while the runner exists; they read the signals through
+// getSnapshot() instead.
+class SimulationRunner
+{
+public:
+    // the runner starts paused
+    explicit SimulationRunner(Graph &graph);
+    ~SimulationRunner();
+
+    SimulationRunner(const SimulationRunner &) = delete;
+    SimulationRunner &operator=(const SimulationRunner &) = delete;
+
+    void run();
+    void pause();
+    bool isRunning() const;
+    // runs num_ticks more as fast as possible, also while paused
+    void step(long long num_ticks = 1);
+
+    // ticks per second while running, 0 for as fast as possible
+    void setTickRate(double ticks_per_second);
+    double getTickRate() const;
+
+    // ticks run so far
+    long long getTick() const { return tick_.load(); }
+    // for one reader thread, see SnapshotPublisher::getLatest()
+    const SignalSnapshot &getSnapshot() { return publisher_.getLatest(); }
+
+private:
+    void thread_loop();
+
+private:
+    static constexpr double MAX_CATCH_UP_SECONDS = 0.25;
+    // ticks between looking at commands when not paced
+    static constexpr long long MAX_BATCH_SIZE = 256;
+
+    Graph &graph_;
+    SnapshotPublisher publisher_;
+    std::atomic<long long> tick_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_{false};
+    bool running_{false};
+    // the accumulator starts over after pauses and tick rate changes
+    bool restart_pacing_{true};
+    long long num_steps_{0};
+    double tick_rate_{0.0};
+
+    std::thread thread_;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+// Dense storage addressed by generational ids. An id packs the slot index into the low bits and
+// the slot generation into the high bits, so an id of a removed element never aliases a new one
+// (until the generation wraps around).
+template<class T>
+class SlotMap
+{
+public:
+    static constexpr int INDEX_BITS = 24;
+    static constexpr int INDEX_MASK = (1 << INDEX_BITS) - 1;
+    static constexpr int MAX_GENERATION = (1 << (31 - INDEX_BITS)) - 1;
+
+    static int getSlotIndex(int id) { return id & INDEX_MASK; }
+    static int getGeneration(int id) { return id >> INDEX_BITS; }
+
+    int insert(T value)
+    {
+        int slot_index;
+        if (free_slots_.empty())
+        {
+            slot_index = slots_.size();
+            assert(slot_index <= INDEX_MASK);
+            slots_.emplace_back();
+        }
+        else
+        {
+            slot_index = free_slots_.back();
+            free_slots_.pop_back();
+        }
+
+        Slot &slot = slots_[slot_index];
+        const int id = make_id(slot_index, slot.generation);
+        slot.dense_index = values_.size();
+        values_.push_back(std::move(value));
+        ids_.push_back(id);
+        return id;
+    }
+
+    void erase(int id)
+    {
+        assert(contains(id));
+        const int slot_index = getSlotIndex(id);
+        Slot &slot = slots_[slot_index];
+
+        const int dense_index = slot.dense_index;
+        const int last_index = values_.size() - 1;
+        if (dense_index != last_index)
+        {
+            values_[dense_index] = std::move(values_[last_index]);
+            ids_[dense_index] = ids_[last_index];
+            slots_[getSlotIndex(ids_[dense_index])].dense_index = dense_index;
+        }
+        values_.pop_back();
+        ids_.pop_back();
+
+        slot.dense_index = -1;
+        slot.generation = slot.generation == MAX_GENERATION ? 0 : slot.generation + 1;
+        free_slots_.push_back(slot_index);
+    }
+
+    bool contains(int id) const
+    {
+        const int slot_index = getSlotIndex(id);
+        if (id < 0 || slot_index >= getNumSlots())
+        {
+            return false;
+        }
+        const Slot &slot = slots_[slot_index];
+        return slot.dense_index != -1 && slot.generation == getGeneration(id);
+    }
+
+    T &get(int id)
+    {
+        assert(contains(id));
+        return values_[slots_[getSlotIndex(id)].dense_index];
+    }
+
+    const T &get(int id) const
+    {
+        assert(contains(id));
+        return values_[slots_[getSlotIndex(id)].dense_index];
+    }
+
+    int size() const { return values_.size(); }
+    bool empty() const { return values_.empty(); }
+
+    // upper bound for getSlotIndex() of any live id, for tables indexed by slot
+    int getNumSlots() const { return slots_.size(); }
+
+    // dense arrays; getIds()[i] is the id of getValues()[i]
+    const std::vector<int> &getIds() const { return ids_; }
+    std::vector<T> &getValues() { return values_; }
+    const std::vector<T> &getValues() const { return values_; }
+
+private:
+    static int make_id(int slot_index, int generation)
+    {
+        return (generation << INDEX_BITS) | slot_index;
+    }
+
+private:
+    struct Slot
+    {
+        int dense_index{-1};
+        int generation{0};
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<int> free_slots_;
+
+    std::vector<T> values_;
+    std::vector<int> ids_;
+};
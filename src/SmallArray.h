@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <memory_resource>
+#include <type_traits>
+
+// Array whose size is fixed at construction. Up to N elements are stored inside the object, so
+// reading them doesn't leave its cache line; larger arrays are allocated from a memory resource.
+template<class T, int N>
+class SmallArray
+{
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+
+public:
+    SmallArray(int size, T value,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : size_(size)
+        , resource_(resource)
+    {
+        assert(size >= 0);
+        if (size > N)
+        {
+            data_ = static_cast<T *>(resource_->allocate(size * sizeof(T), alignof(T)));
+        }
+        std::fill(data_, data_ + size_, value);
+    }
+
+    ~SmallArray()
+    {
+        if (data_ != inline_)
+        {
+            resource_->deallocate(data_, size_ * sizeof(T), alignof(T));
+        }
+    }
+
+    SmallArray(const SmallArray &) = delete;
+    SmallArray &operator=(const SmallArray &) = delete;
+
+    int size() const { return size_; }
+    bool isInline() const { return data_ == inline_; }
+
+    T &operator[](int i)
+    {
+        assert(i >= 0 && i < size_);
+        return data_[i];
+    }
+    const T &operator[](int i) const
+    {
+        assert(i >= 0 && i < size_);
+        return data_[i];
+    }
+
+    T *begin() { return data_; }
+    T *end() { return data_ + size_; }
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + size_; }
+
+private:
+    int size_{0};
+    std::pmr::memory_resource *resource_{nullptr};
+    T *data_{inline_};
+    T inline_[N];
+};
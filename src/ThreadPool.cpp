@@ -0,0 +1,104 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+// chunks per thread; more chunks even out nodes of different cost
+constexpr int CHUNKS_PER_THREAD = 4;
+} // namespace
+
+ThreadPool::ThreadPool(int num_threads)
+{
+    assert(num_threads >= 1);
+    for (int i = 1; i < num_threads; ++i)
+    {
+        workers_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (std::thread &worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)> &task)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    if (workers_.empty())
+    {
+        task(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        count_ = count;
+        chunk_size_ = std::max(1, count / (getNumThreads() * CHUNKS_PER_THREAD));
+        next_chunk_ = 0;
+        num_busy_workers_ = workers_.size();
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    run_chunks();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return num_busy_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::worker_loop()
+{
+    int seen_generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&]() { return stop_ || generation_ != seen_generation; });
+            if (stop_)
+            {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        run_chunks();
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last = --num_busy_workers_ == 0;
+        }
+        if (last)
+        {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+void ThreadPool::run_chunks()
+{
+    while (true)
+    {
+        const int begin = next_chunk_.fetch_add(chunk_size_);
+        if (begin >= count_)
+        {
+            return;
+        }
+        (*task_)(begin, std::min(begin + chunk_size_, count_));
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // the calling thread takes part in every parallelFor(), so num_threads - 1 workers are started
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int getNumThreads() const { return workers_.size() + 1; }
+
+    // splits [0, count) into chunks and calls task(begin, end) for each of them;
+    // returns when all chunks are done
+    void parallelFor(int count, const std::function<void(int begin, int end)> &task);
+
+private:
+    void worker_loop();
+    void run_chunks();
+
+private:
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    bool stop_{false};
+    int generation_{0};
+    int num_busy_workers_{0};
+
+    const std::function<void(int, int)> *task_{nullptr};
+    int count_{0};
+    int chunk_size_{1};
+    std::atomic<int> next_chunk_{0};
+};
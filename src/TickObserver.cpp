@@ -0,0 +1,8 @@
+#include "TickObserver.h"
+
+#include "Graph.h"
+
+void SignalProbe::onTick(const Graph &graph, long long tick)
+{
+    memory_.push_back(graph.getNode(node_).getOutput(output_));
+}
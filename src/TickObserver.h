@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Signal.h"
+
+#include <utility>
+#include <vector>
+
+class Graph;
+
+// Called by Graph once per tick, not once per node. Observers must not change the structure of
+// the graph they observe.
+class TickObserver
+{
+public:
+    virtual ~TickObserver() = default;
+
+    // tick is the index of the tick that was just calculated, counting from 0
+    virtual void onTick(const Graph &graph, long long tick) = 0;
+    // called at the end of every Graph::run()/runUntil(), also when it ran no ticks
+    virtual void onRunFinished(const Graph &graph, long long first_tick, long long num_ticks) {}
+};
+
+// Records node outputs after every tick, like a MemoryNode that isn't part of the graph.
+class SignalProbe final : public TickObserver
+{
+public:
+    SignalProbe(int node, int output = 0)
+        : node_(node)
+        , output_(output)
+    {}
+
+    void clearMemory() { memory_.clear(); }
+    const std::vector<Signal> &getMemory() const { return memory_; }
+
+    void onTick(const Graph &graph, long long tick) override;
+
+private:
+    int node_{-1};
+    int output_{0};
+    std::vector<Signal> memory_;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// Priority queue of values keyed by integer time, for times that only move forward. Level 0 has
+// one bucket per time unit of the next SLOTS units; level i buckets cover SLOTS^i units each and
+// are spread into the lower levels when the current time reaches them. schedule() is O(1), every
+// value is moved at most LEVELS - 1 times before it is taken.
+//
+// Values further than SLOTS^LEVELS units ahead wait in an overflow list.
+template<class T>
+class TimingWheel
+{
+public:
+    static constexpr int SLOT_BITS = 8;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+    static constexpr int LEVELS = 4;
+
+    TimingWheel()
+        : levels_(LEVELS, std::vector<Bucket>(SLOTS))
+    {}
+
+    long long getTime() const { return time_; }
+    long long size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void schedule(long long time, T value)
+    {
+        assert(time >= time_);
+        ++size_;
+        place({time, std::move(value)});
+    }
+
+    // moves the values scheduled for getTime() to the end of out
+    void takeCurrent(std::vector<T> &out)
+    {
+        Bucket &bucket = levels_[0][time_ & (SLOTS - 1)];
+        for (Entry &entry : bucket)
+        {
+            assert(entry.time == time_);
+            out.push_back(std::move(entry.value));
+        }
+        size_ -= bucket.size();
+        bucket.clear();
+    }
+
+    // the values of the current time must have been taken
+    void advance()
+    {
+        assert(levels_[0][time_ & (SLOTS - 1)].empty());
+        ++time_;
+
+        if ((static_cast<std::uint64_t>(time_) & get_mask(LEVELS)) == 0)
+        {
+            std::vector<Entry> overflow;
+            overflow.swap(overflow_);
+            for (Entry &entry : overflow)
+            {
+                place(std::move(entry));
+            }
+        }
+        cascade();
+    }
+
+    // jumps ahead without visiting the times in between, only when nothing is scheduled
+    void skipTo(long long time)
+    {
+        assert(empty() && time >= time_);
+        time_ = time;
+    }
+
+private:
+    struct Entry
+    {
+        long long time{0};
+        T value;
+    };
+    using Bucket = std::vector<Entry>;
+
+    void place(Entry entry)
+    {
+        const std::uint64_t distance = static_cast<std::uint64_t>(entry.time ^ time_);
+        for (int level = 0; level < LEVELS; ++level)
+        {
+            if ((distance >> (SLOT_BITS * (level + 1))) == 0)
+            {
+                const int slot = (entry.time >> (SLOT_BITS * level)) & (SLOTS - 1);
+                levels_[level][slot].push_back(std::move(entry));
+                return;
+            }
+        }
+        overflow_.push_back(std::move(entry));
+    }
+
+    // spreads the buckets that start at the current time, higher levels first so that their
+    // values can land in a lower bucket that is spread next
+    void cascade()
+    {
+        for (int level = LEVELS - 1; level >= 1; --level)
+        {
+            if (static_cast<std::uint64_t>(time_) & get_mask(level))
+            {
+                continue;
+            }
+            Bucket bucket;
+            bucket.swap(levels_[level][(time_ >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+            for (Entry &entry : bucket)
+            {
+                place(std::move(entry));
+            }
+        }
+    }
+
+    static std::uint64_t get_mask(int level)
+    {
+        return (std::uint64_t{1} << (SLOT_BITS * level)) - 1;
+    }
+
+private:
+    long long time_{0};
+    long long size_{0};
+    std::vector<std::vector<Bucket>> levels_;
+    std::vector<Entry> overflow_;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+// Hands values from one writer thread to one reader thread without locks or waiting. The writer
+// fills getWriteBuffer() and publishes it; the reader takes the most recently published buffer
+// with update() and reads it until the next update(). Buffers published in between are skipped,
+// so a slow reader never holds the writer up.
+//
+// Of the three buffers one belongs to the writer, one to the reader, and the third is exchanged
+// between them atomically together with a flag telling whether it was published after the
+// reader's last update().
+template<class T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    explicit TripleBuffer(const T &value)
+        : buffers_{value, value, value}
+    {}
+
+    // writer side
+    T &getWriteBuffer() { return buffers_[back_]; }
+    void publish()
+    {
+        back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader side; returns false if nothing was published since the last update()
+    bool update()
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH))
+        {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T &getReadBuffer() const { return buffers_[front_]; }
+
+private:
+    static constexpr int INDEX = 3;
+    static constexpr int FRESH = 4;
+
+    std::array<T, 3> buffers_;
+    alignas(64) std::atomic<int> middle_{1};
+    alignas(64) int back_{0};
+    alignas(64) int front_{2};
+};
@@ -4,9 +4,11 @@
 #include "LineShape.h"
 #include "MathUtils.h"
 #include "Nodes.h"
+#include "SimulationRunner.h"
 #include "ViewCommon.h"
 
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
@@ -42,10 +44,6 @@ int main()
     auto &node_4 = graph.getNode(n4);
     node_4.setName("node_4");
 
-    auto n5 = graph.createNode<MemoryNode>();
-    auto &node_5 = graph.getNode(n5);
-    node_5.setName("node_5");
-
     auto n6 = graph.createNode<TriangleSignalNode>(-1.f, 1.f, 0.f, 0.1f);
     auto &node_6 = graph.getNode(n6);
     node_6.setName("node_6");
@@ -69,17 +67,29 @@ int main()
     graph.connect(n1, 0, n7, 0);
     graph.connect(n6, 0, n7, 1);
 
-    graph.connect(n4, 0, n5, 0);
-
     View::GraphView graph_view{graph};
 
+    // from here on the graph belongs to the simulation thread, the loop below only reads snapshots
+    SimulationRunner runner{graph};
+    double tick_rate = 1000.0;
+    runner.setTickRate(tick_rate);
+
+    // output of node_4 as sampled by the snapshots, one point per tick seen; only the latest
+    // points are kept, the runner can produce hundreds of thousands of ticks per second
+    constexpr int MAX_PLOT_POINTS = 4096;
+    std::vector<sf::Vertex> plot;
+    long long last_tick = -1;
+
     sf::Text info_text{"", Globals::getFont(), 30};
-    int iteration = 0;
 
     const auto update_info = [&]() {
         sf::String str;
         str += "Iteration: ";
-        str += std::to_string(iteration);
+        str += std::to_string(last_tick + 1);
+        str += runner.isRunning() ? "  running at " : "  paused at ";
+        const double rate = runner.getTickRate();
+        str += rate == 0.0 ? "max" : std::to_string((long long)rate);
+        str += " ticks/s";
         info_text.setString(str);
         info_text.setOrigin(Math::getBottomRight(info_text));
         // dont need transforms because gui_view has same coordinates as window
@@ -106,10 +116,30 @@ int main()
             {
                 if (event.key.code == sf::Keyboard::Space)
                 {
-                    graph.iterate();
-                    graph_view.updateIOStates();
-                    iteration++;
-                    update_info();
+                    if (runner.isRunning())
+                    {
+                        runner.pause();
+                    }
+                    else
+                    {
+                        runner.run();
+                    }
+                }
+                if (event.key.code == sf::Keyboard::Enter)
+                {
+                    // shift+enter steps a batch of ticks
+                    runner.step(event.key.shift ? 100 : 1);
+                }
+                if (event.key.code == sf::Keyboard::Up || event.key.code == sf::Keyboard::Down)
+                {
+                    tick_rate = event.key.code == sf::Keyboard::Up ? tick_rate * 2.0
+                                                                   : std::max(1.0, tick_rate / 2.0);
+                    runner.setTickRate(tick_rate);
+                }
+                if (event.key.code == sf::Keyboard::F)
+                {
+                    // toggles running as fast as possible
+                    runner.setTickRate(runner.getTickRate() == 0.0 ? tick_rate : 0.0);
                 }
             }
             if (event.type == sf::Event::MouseWheelScrolled)
@@ -170,29 +200,35 @@ int main()
         const sf::Vector2f scroll_move = (new_rel_pos - old_rel_pos);
         main_view.move(scroll_move);
 
+        const SignalSnapshot &snapshot = runner.getSnapshot();
+        if (snapshot.getTick() != last_tick)
+        {
+            last_tick = snapshot.getTick();
+            graph_view.updateIOStates(snapshot);
+
+            const Signal signal = snapshot.getOutput(n4, 0);
+            if (signal.isValid())
+            {
+                sf::Vertex v;
+                v.position.y = signal.getFloat() * 100;
+                v.position.x = (float)last_tick;
+                v.color = View::colorFromSignal(signal);
+                plot.push_back(v);
+            }
+            if (static_cast<int>(plot.size()) >= 2 * MAX_PLOT_POINTS)
+            {
+                // dropped in batches so the points don't move on every tick
+                plot.erase(plot.begin(), plot.end() - MAX_PLOT_POINTS);
+            }
+        }
+        update_info();
+
         // draw main
         window.setView(main_view);
         window.clear({60, 63, 65});
         window.draw(graph_view);
 
-
-        std::vector<sf::Vertex> vertices;
-        const std::vector<Signal> &memory = object_cast<MemoryNode>(&node_5)->getMemory();
-        for (int i = 0, count = memory.size(); i < count; i++)
-        {
-            const Signal &signal = memory[i];
-            if (!signal.isValid())
-            {
-                continue;
-            }
-
-            sf::Vertex v;
-            v.position.y = signal.getFloat() * 100;
-            v.position.x = (float)i;
-            v.color = View::colorFromSignal(signal);
-            vertices.push_back(v);
-        }
-        window.draw(vertices.data(), vertices.size(), sf::LineStrip);
+        window.draw(plot.data(), plot.size(), sf::LineStrip);
 
         // draw gui
         window.setView(gui_view);
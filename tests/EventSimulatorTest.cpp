@@ -0,0 +1,115 @@
+#include "EventSimulator.h"
+#include "Graph.h"
+#include "Nodes.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+// EventSimulator against Graph::iterate() on random graphs with registers: with every path
+// shorter than a tick, all outputs, register outputs included, must match at the end of a tick.
+namespace
+{
+constexpr int NUM_SEEDS = 20;
+constexpr int NUM_NODES = 200;
+constexpr int NUM_TICKS = 30;
+constexpr int MAX_DELAY = 3;
+// longer than any path of NUM_NODES nodes
+constexpr int TICK_LENGTH = NUM_NODES * MAX_DELAY + 1;
+
+// the same graph for the same seed; combinational nodes are only driven by earlier nodes, so
+// cycles only pass through registers
+std::vector<int> build(Graph &graph, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<int> ids;
+    std::vector<int> registers;
+    for (int i = 0; i < NUM_NODES; ++i)
+    {
+        const int kind = i < 4 ? rng() % 2 : rng() % 9;
+        int id;
+        switch (kind)
+        {
+        case 0: id = graph.createNode<TriangleSignalNode>(-1.f, 1.f, 0.f, 0.11f); break;
+        case 1: id = graph.createNode<ConstantNode>(Signal{static_cast<float>(rng() % 3)}); break;
+        case 2: id = graph.createNode<SumNode>(1 + rng() % 3); break;
+        case 3: id = graph.createNode<MultiplicationNode>(2); break;
+        case 4: id = graph.createNode<NegateNode>(); break;
+        case 5: id = graph.createNode<AndNode>(2); break;
+        case 6: id = graph.createNode<NotNode>(); break;
+        case 7: id = graph.createNode<DelayNode>(Signal{0.5f}); break;
+        default: id = graph.createNode<DFlipFlopNode>(rng() % 2); break;
+        }
+
+        Node &node = graph.getNode(id);
+        if (node.isRegister())
+        {
+            registers.push_back(id);
+        }
+        else
+        {
+            for (int input = 0, count = node.getNumInputs(); input < count; ++input)
+            {
+                graph.connect(ids[rng() % ids.size()], 0, id, input);
+            }
+        }
+        ids.push_back(id);
+    }
+    for (const int id : registers)
+    {
+        graph.connect(ids[rng() % ids.size()], 0, id, 0);
+    }
+    return ids;
+}
+} // namespace
+
+int main()
+{
+    int num_mismatches = 0;
+    for (unsigned seed = 1; seed <= NUM_SEEDS; ++seed)
+    {
+        Graph reference;
+        Graph graph;
+        const std::vector<int> reference_ids = build(reference, seed);
+        const std::vector<int> ids = build(graph, seed);
+
+        EventSimulator simulator(graph, TICK_LENGTH);
+        std::mt19937 rng(seed);
+        for (const int id : ids)
+        {
+            simulator.setDelay(id, 1 + rng() % MAX_DELAY);
+        }
+
+        for (int tick = 0; tick < NUM_TICKS; ++tick)
+        {
+            reference.iterate();
+            simulator.iterate();
+            for (int i = 0; i < NUM_NODES; ++i)
+            {
+                const Node &node = reference.getNode(reference_ids[i]);
+                for (int output = 0, count = node.getNumOutputs(); output < count; ++output)
+                {
+                    const Signal expected = node.getOutput(output);
+                    const Signal actual = simulator.getOutput(ids[i], output);
+                    if (!expected.isIdentical(actual))
+                    {
+                        if (num_mismatches == 0)
+                        {
+                            std::cout << "seed " << seed << " tick " << tick << " "
+                                      << node.getType() << ": " << expected << " vs " << actual
+                                      << std::endl;
+                        }
+                        ++num_mismatches;
+                    }
+                }
+            }
+        }
+    }
+
+    if (num_mismatches > 0)
+    {
+        std::cout << num_mismatches << " mismatches" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "Graph.h"
+#include "Nodes.h"
+
+#include <iostream>
+#include <vector>
+
+// EvaluationMode::Incremental against EvaluationMode::Scheduled when a node that drives a
+// MemoryNode can no longer be calculated: the memory keeps recording the last signal it got.
+namespace
+{
+constexpr int NUM_TICKS = 5;
+
+// a register whose state becomes invalid on the second tick, behind a negation and a memory
+std::vector<Signal> record(Graph::EvaluationMode mode)
+{
+    Graph graph;
+    graph.setEvaluationMode(mode);
+
+    const int invalid = graph.createNode<ConstantNode>(Signal::INVALID());
+    const int delay = graph.createNode<DelayNode>(Signal{0.5f});
+    const int negate = graph.createNode<NegateNode>();
+    const int memory = graph.createNode<MemoryNode>();
+    graph.connect(invalid, 0, delay, 0);
+    graph.connect(delay, 0, negate, 0);
+    graph.connect(negate, 0, memory, 0);
+
+    graph.run(NUM_TICKS);
+    return object_cast<MemoryNode>(&graph.getNode(memory))->getMemory();
+}
+} // namespace
+
+int main()
+{
+    const std::vector<Signal> scheduled = record(Graph::EvaluationMode::Scheduled);
+    const std::vector<Signal> incremental = record(Graph::EvaluationMode::Incremental);
+
+    bool same = scheduled.size() == incremental.size();
+    for (int i = 0, count = scheduled.size(); same && i < count; ++i)
+    {
+        same = scheduled[i].isIdentical(incremental[i]);
+    }
+    if (!same)
+    {
+        std::cout << "memory differs:";
+        for (int i = 0, count = scheduled.size(); i < count; ++i)
+        {
+            std::cout << " " << scheduled[i] << "/"
+                      << (i < static_cast<int>(incremental.size()) ? incremental[i] : Signal{});
+        }
+        std::cout << std::endl;
+        return 1;
+    }
+    return 0;
+}